@@ -0,0 +1,49 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+// The global operator new behind MZED_COUNT_ALLOCATIONS. Only compiled into the externals and
+// their tests when that option is on; see mzed.allocations.h.
+
+#include "mzed.allocations.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace mzed
+{
+    thread_local size_t thread_allocations{};
+}
+
+void* operator new(std::size_t size)
+{
+    ++mzed::thread_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,66 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include <cstddef>
+
+// Debug aid for the real-time paths: configure with -DMZED_COUNT_ALLOCATIONS=ON and every heap
+// allocation made inside an allocation_scope is counted. The replacement operator new that does
+// the counting lives in mzed.allocations.cpp, which the build adds to each external only when
+// the option is on.
+
+#ifdef MZED_COUNT_ALLOCATIONS
+
+namespace mzed
+{
+    /// Heap allocations made on this thread, counted by the replacement operator new.
+    extern thread_local size_t thread_allocations;
+}
+
+#endif
+
+namespace mzed
+{
+    /// Allocations seen by one instrumented call site.
+    struct allocation_counter
+    {
+        size_t last{};  // during the most recent call
+        size_t peak{};  // worst call so far
+        size_t calls{};
+    };
+
+    /// Counts the allocations made on this thread between construction and destruction.
+    /// Compiles to nothing unless MZED_COUNT_ALLOCATIONS is defined.
+    class allocation_scope
+    {
+    public:
+#ifdef MZED_COUNT_ALLOCATIONS
+        allocation_scope(allocation_counter& counter) : m_counter{ counter }, m_start{ thread_allocations } {}
+
+        ~allocation_scope()
+        {
+            m_counter.last = thread_allocations - m_start;
+            if (m_counter.last > m_counter.peak) m_counter.peak = m_counter.last;
+            ++m_counter.calls;
+        }
+
+    private:
+        allocation_counter& m_counter;
+        const size_t m_start;
+#else
+        allocation_scope(allocation_counter&) {}
+#endif
+    };
+
+    constexpr bool counting_allocations
+    {
+#ifdef MZED_COUNT_ALLOCATIONS
+        true
+#else
+        false
+#endif
+    };
+}
@@ -0,0 +1,189 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "c74_min.h"
+#include "mzed.allocations.h"
+#include "mzed.events.h"
+#include "mzed.point.h"
+#include "mzed.precision.h"
+#include "mzed.profiler.h"
+#include "mzed.recorder.h"
+#include "mzed.sweep.h"
+
+#include <vector>
+
+namespace mzed
+{
+    /// Everything lorenz, chua and roessler do besides their equations: stepping in either
+    /// precision, watching for events, recording, sweeping, and the stats and allocations
+    /// reports. Each object forwards its messages here. EQUATIONS supplies
+    ///   - coefficients, the numbers one step needs, including the timestep h,
+    ///   - static point step<REAL>(const point&, const coefficients&), one Euler step with the
+    ///     derivatives evaluated in REAL,
+    ///   - static double coefficients::*sweepable(const symbol&), the coefficient a sweep
+    ///     message names, or nullptr,
+    ///   - static constexpr int sweep_axis, the coordinate whose maxima a sweep follows.
+    template <typename EQUATIONS>
+    class attractor
+    {
+    public:
+        using coefficients = typename EQUATIONS::coefficients;
+
+        attractor(c74::min::outlet<>& x, c74::min::outlet<>& y, c74::min::outlet<>& z, c74::min::outlet<>& dumpout, const point& start)
+        : current{ start }, m_x{ x }, m_y{ y }, m_z{ z }, m_dumpout{ dumpout }
+        {}
+
+        point current;
+
+        /// Set one coordinate of the current point, as the coordinate inlets do.
+        void set(const int axis, const double value)
+        {
+            if (axis == 0) current.x = value;
+            else if (axis == 1) current.y = value;
+            else current.z = value;
+            m_events.reset();
+        }
+
+        /// bang: step once, or as far as the next event when watching for them, and send the
+        /// point out. The caller reads its attributes once per bang and passes them in, so a
+        /// long search runs with one set of settings.
+        void bang(const coefficients& k, const precisions precision, const events watching, const axes axis, const double section)
+        {
+            point found{};
+            bool sending{};
+            {
+                // only our own work: whatever the outlets' receivers allocate or spend isn't counted
+                allocation_scope scope{ m_bangAllocations };
+                profile_scope timing{ m_bangTime };
+                sending = integrate(k, precision == precisions::single_precision, watching, static_cast<int>(axis), section, found);
+                if (sending) m_recorder.push(m_step, found.x, found.y, found.z);
+            }
+            if (sending) send(found);
+        }
+
+        /// Report steps, steps/sec and messages sent since the last report, and frames dropped
+        /// by the current or last recording, out the dumpout (plus ns per step with MZED_PROFILE).
+        void stats()
+        {
+            const double seconds{ m_statsWindow.restart() };
+            const double steps{ static_cast<double>(m_step - m_reportedStep) };
+            m_reportedStep = m_step;
+
+            m_dumpout.send("steps", steps);
+            m_dumpout.send("steps_per_sec", seconds > 0.0 ? steps / seconds : 0.0);
+            m_dumpout.send("messages_sent", 3.0 * (m_emitted - m_reportedEmitted));
+            m_dumpout.send("recording_dropped", static_cast<double>(m_recorder.dropped()));
+            if (profiling) m_dumpout.send("ns_per_step", steps > 0.0 ? m_bangTime.nanoseconds / steps : 0.0);
+            m_reportedEmitted = m_emitted;
+            m_bangTime.clear();
+        }
+
+        /// Integrate copies of the attractor from the current point across a range of one
+        /// coefficient of k; empty if the coefficient can't be swept.
+        std::vector<sweep_run> sweep(const c74::min::symbol& name, const sweep_settings& settings, const coefficients& k) const
+        {
+            const auto swept{ EQUATIONS::sweepable(name) };
+            if (!swept) return {};
+
+            return mzed::sweep(settings, current, k, swept, EQUATIONS::sweep_axis, [](const point& from, const coefficients& with) {
+                return EQUATIONS::template step<double>(from, with);
+            });
+        }
+
+        /// sweep message: run the sweep its arguments describe and send the results out the
+        /// dumpout as a dictionary. Returns false, having run nothing, if they don't describe one.
+        bool sweep(const c74::min::atoms& args, const coefficients& k)
+        {
+            const auto settings{ sweep_request(args) };
+            const auto runs{ settings ? sweep(args[0], *settings, k) : std::vector<sweep_run>{} };
+            if (runs.empty()) return false;
+
+            write_sweep(m_sweep, args[0], runs);
+            m_dumpout.send("dictionary", m_sweep.name());
+            return true;
+        }
+
+        /// Allocations counted in bang's own work, with MZED_COUNT_ALLOCATIONS.
+        const allocation_counter& bang_allocations() const
+        {
+            return m_bangAllocations;
+        }
+
+        template <typename LOG>
+        void allocations(LOG& log) const
+        {
+            if (counting_allocations) log << "bang: " << m_bangAllocations.last << " allocations in the last call, " << m_bangAllocations.peak << " at most" << c74::min::endl;
+            else log << "allocation counting is not compiled in, configure with -DMZED_COUNT_ALLOCATIONS=ON" << c74::min::endl;
+        }
+
+        /// record message; see record_message. Returns false if the file could not be opened.
+        template <typename LOG>
+        bool record(const c74::min::atoms& args, LOG& log)
+        {
+            return record_message(m_recorder, args, log);
+        }
+
+    private:
+        c74::min::outlet<>& m_x;
+        c74::min::outlet<>& m_y;
+        c74::min::outlet<>& m_z;
+        c74::min::outlet<>& m_dumpout;
+
+        uint64_t m_step{};
+        recorder<4> m_recorder{ { "step", "x", "y", "z" } };
+        allocation_counter m_bangAllocations{};
+        c74::min::atoms m_out{ 0.0 };
+        section_timer m_bangTime{};
+        stats_window m_statsWindow{};
+        uint64_t m_reportedStep{};
+        uint64_t m_emitted{};
+        uint64_t m_reportedEmitted{};
+        event_detector m_events{};
+        c74::min::dict m_sweep{ c74::min::symbol(true) };
+
+        /// One step, in the arithmetic the precision attribute selects.
+        void advance(const coefficients& k, const bool single)
+        {
+            current = single ? EQUATIONS::template step<float>(current, k) : EQUATIONS::template step<double>(current, k);
+            ++m_step;
+        }
+
+        /// Step once, or as far as the next event along axis, leaving the point to send in
+        /// found; false if no event turned up within event_step_limit steps.
+        bool integrate(const coefficients& k, const bool single, const events watching, const int axis, const double section, point& found)
+        {
+            if (watching == events::off)
+            {
+                // these steps aren't fed to the detector, so it mustn't join them up with later ones
+                m_events.reset();
+                advance(k, single);
+                found = current;
+                return true;
+            }
+
+            double ago{};
+            for (int n{}; n < event_step_limit; ++n)
+            {
+                advance(k, single);
+                if (m_events.next(current, watching, axis, section, found, ago)) return true;
+            }
+            return false;
+        }
+
+        /// Send a point out, z first, through a reusable atom so sending doesn't allocate.
+        void send(const point& p)
+        {
+            m_out[0] = p.z;
+            m_z.send(m_out);
+            m_out[0] = p.y;
+            m_y.send(m_out);
+            m_out[0] = p.x;
+            m_x.send(m_out);
+            ++m_emitted;
+        }
+    };
+}
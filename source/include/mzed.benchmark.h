@@ -0,0 +1,60 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+// Throughput checks for the unit tests. Each test times an object's own stepping code directly,
+// not its messages and outlets, and states the rate it measured in each build type when its
+// baseline was set; a run fails if it falls more than regression_tolerance below the baseline
+// for the build type it was compiled in. Raise the baselines when an object gets faster. Set
+// MZED_SKIP_BENCHMARKS in the environment to skip the rate check on machines that are known to
+// be slow or busy.
+
+namespace mzed
+{
+    constexpr double regression_tolerance{ 0.2 };
+
+    /// The baseline for the build type being compiled: Debug builds run unoptimised, so they
+    /// are held to a different rate from Release builds.
+    constexpr double baseline(const double debug, const double release)
+    {
+#ifdef NDEBUG
+        (void)debug;
+        return release;
+#else
+        (void)release;
+        return debug;
+#endif
+    }
+
+    /// Calls step() count times, runs times over, and returns the best rate in calls per
+    /// second, so one interruption doesn't fail a check this tight.
+    template <typename STEP>
+    double steps_per_second(const int count, STEP&& step, const int runs = 3)
+    {
+        double best{};
+        for (int run{}; run < runs; ++run)
+        {
+            const auto start{ std::chrono::steady_clock::now() };
+            for (int i{}; i < count; ++i)
+            {
+                step();
+            }
+            const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+            best = std::max(best, count / elapsed.count());
+        }
+        return best;
+    }
+
+    inline bool meets_baseline(const double rate, const double baseline)
+    {
+        if (std::getenv("MZED_SKIP_BENCHMARKS")) return true;
+        return rate >= baseline * (1.0 - regression_tolerance);
+    }
+}
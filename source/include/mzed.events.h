@@ -0,0 +1,103 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "c74_min.h"
+#include "mzed.point.h"
+
+#include <algorithm>
+
+namespace mzed
+{
+    /// What an attractor's bang reports, chosen with its "events" attribute: every step, or only
+    /// the next upward crossing of a section plane, maximum or minimum along one axis.
+    enum class events { off, crossing, maxima, minima, enum_count };
+
+    inline c74::min::enum_map event_range{ "off", "crossing", "maxima", "minima" };
+
+    enum class axes { x, y, z, enum_count };
+
+    inline c74::min::enum_map axis_range{ "x", "y", "z" };
+
+    /// How far a bang integrates looking for an event before giving up, e.g. on a fixed point.
+    constexpr int event_step_limit{ 100000 };
+
+    /// Watches consecutive points of a trajectory for events. Crossings are placed by linear
+    /// interpolation between the two points either side of the section; extrema by fitting a
+    /// parabola through the three points around the extreme sample, which is evaluated for all
+    /// three coordinates at the vertex.
+    class event_detector
+    {
+    public:
+        /// Forget the trajectory so far, e.g. after its state was set from outside.
+        void reset()
+        {
+            m_seen = 0;
+        }
+
+        /// Feed the next point. Returns true if an event happened since the previous point
+        /// (crossings) or around it (extrema), with the interpolated point in at and the number
+        /// of steps (0 to 1.5) between the event and p in ago.
+        /// Changing kind or axis starts the watch afresh.
+        bool next(const point& p, const events kind, const int axis, const double section, point& at, double& ago)
+        {
+            if (kind != m_kind || axis != m_axis)
+            {
+                reset();
+                m_kind = kind;
+                m_axis = axis;
+            }
+
+            bool found{};
+
+            if (kind == events::crossing && m_seen >= 1)
+            {
+                const double a{ coordinate(m_previous, axis) - section };
+                const double b{ coordinate(p, axis) - section };
+
+                if (a < 0.0 && b >= 0.0)
+                {
+                    const double t{ a / (a - b) };
+                    at = { m_previous.x + t * (p.x - m_previous.x), m_previous.y + t * (p.y - m_previous.y), m_previous.z + t * (p.z - m_previous.z) };
+                    ago = 1.0 - t;
+                    found = true;
+                }
+            }
+            else if ((kind == events::maxima || kind == events::minima) && m_seen >= 2)
+            {
+                const double sign{ kind == events::maxima ? 1.0 : -1.0 };
+                const double a{ sign * coordinate(m_before, axis) };
+                const double b{ sign * coordinate(m_previous, axis) };
+                const double c{ sign * coordinate(p, axis) };
+
+                if (b > a && b >= c)
+                {
+                    const double curvature{ a - 2 * b + c };
+                    const double s{ curvature < 0.0 ? 0.5 * (a - c) / curvature : 0.0 };
+                    const auto vertex{ [s](const double before, const double previous, const double now) {
+                        return previous + s * (now - before) * 0.5 + s * s * (now - 2 * previous + before) * 0.5;
+                    } };
+
+                    at = { vertex(m_before.x, m_previous.x, p.x), vertex(m_before.y, m_previous.y, p.y), vertex(m_before.z, m_previous.z, p.z) };
+                    ago = 1.0 - s;
+                    found = true;
+                }
+            }
+
+            m_before = m_previous;
+            m_previous = p;
+            m_seen = std::min(m_seen + 1, 2);
+            return found;
+        }
+
+    private:
+        point m_before{};
+        point m_previous{};
+        int m_seen{};
+        events m_kind{ events::off };
+        int m_axis{};
+    };
+}
@@ -0,0 +1,47 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "mzed.triplebuffer.h"
+
+#include <mutex>
+
+namespace mzed
+{
+    /// Settings changed from Max and read by a thread that does the work, such as a simulation
+    /// or audio thread. The worker calls acquire() once per step or audio block and uses that
+    /// copy throughout, so it never waits on a setter and never sees a half-made change. Setters
+    /// take turns with each other, but never with the worker.
+    template <typename T>
+    class parameter_block
+    {
+    public:
+        explicit parameter_block(const T& initial) : m_latest{ initial }, m_exchange{ initial } {}
+
+        /// Setter: change some of the settings with change(T&) and hand the whole block over.
+        template <typename F>
+        void change(F&& change)
+        {
+            std::lock_guard<std::mutex> lock{ m_setters };
+            change(m_latest);
+            m_exchange.back() = m_latest;
+            m_exchange.publish();
+        }
+
+        /// Worker: the newest settings handed over. The reference stays valid, and the settings
+        /// unchanged, until the next acquire().
+        const T& acquire()
+        {
+            m_exchange.update();
+            return m_exchange.front();
+        }
+
+    private:
+        std::mutex m_setters{};
+        T m_latest;
+        triple_buffer<T> m_exchange;
+    };
+}
@@ -0,0 +1,28 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+namespace mzed
+{
+    /// A point in the phase space of a three-dimensional attractor.
+    /// The attractors keep their state in double whatever their precision attribute says: in
+    /// float, only the derivatives are evaluated in single precision, so each increment is
+    /// rounded but the accumulated trajectory doesn't drift the way a float state would.
+    /// For the attractors float is an accuracy setting, not a speed-up: a step is a few scalar
+    /// operations, and converting to float and back makes it about a third slower than double.
+    struct point
+    {
+        double x;
+        double y;
+        double z;
+    };
+
+    /// The x (0), y (1) or z (2) coordinate of a point.
+    inline double coordinate(const point& p, const int axis)
+    {
+        return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+    }
+}
@@ -0,0 +1,18 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "c74_min.h"
+
+namespace mzed
+{
+    /// Arithmetic used by an object's simulation, chosen with its "precision" attribute. Each
+    /// object instantiates its stepping code for both float and double and documents which
+    /// parts stay in double when running in float.
+    enum class precisions { double_precision, single_precision, enum_count };
+
+    inline c74::min::enum_map precision_range{ "double", "float" };
+}
@@ -0,0 +1,82 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Counters behind the objects' "stats" message. Cheap per-call counts are always kept; timers and
+// counts inside inner loops are only compiled in when the package is configured with
+// -DMZED_PROFILE=ON, so release builds pay nothing for them.
+
+namespace mzed
+{
+    constexpr bool profiling
+    {
+#ifdef MZED_PROFILE
+        true
+#else
+        false
+#endif
+    };
+
+    /// Time spent in one instrumented section since the last stats report.
+    struct section_timer
+    {
+        uint64_t calls{};
+        uint64_t nanoseconds{};
+
+        double ns_per_call() const
+        {
+            return calls ? static_cast<double>(nanoseconds) / calls : 0.0;
+        }
+
+        void clear()
+        {
+            calls = 0;
+            nanoseconds = 0;
+        }
+    };
+
+    /// Adds the lifetime of the scope to a section_timer. Compiles to nothing unless MZED_PROFILE is defined.
+    class profile_scope
+    {
+    public:
+#ifdef MZED_PROFILE
+        profile_scope(section_timer& timer) : m_timer{ timer }, m_start{ std::chrono::steady_clock::now() } {}
+
+        ~profile_scope()
+        {
+            const auto elapsed{ std::chrono::steady_clock::now() - m_start };
+            m_timer.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            ++m_timer.calls;
+        }
+
+    private:
+        section_timer& m_timer;
+        const std::chrono::steady_clock::time_point m_start;
+#else
+        profile_scope(section_timer&) {}
+#endif
+    };
+
+    /// Wall-clock time between two stats reports, for per-second rates.
+    class stats_window
+    {
+    public:
+        /// Seconds since the previous call (or construction); starts a new window.
+        double restart()
+        {
+            const auto now{ std::chrono::steady_clock::now() };
+            const std::chrono::duration<double> elapsed{ now - m_start };
+            m_start = now;
+            return elapsed.count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start{ std::chrono::steady_clock::now() };
+    };
+}
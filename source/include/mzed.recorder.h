@@ -0,0 +1,215 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "c74_min.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mzed
+{
+    /// Streams fixed-width frames of doubles to disk without blocking the caller.
+    /// push() is called from the object's thread (scheduler or main) and only touches a
+    /// single-producer/single-consumer ring; a writer thread drains the ring to a CSV or
+    /// raw binary (native-endian float64) file. When the ring is full, frames are dropped
+    /// and counted rather than waited for.
+    template <size_t WIDTH, size_t CAPACITY = 65536>
+    class recorder
+    {
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "recorder capacity must be a power of two");
+
+    public:
+        using frame = std::array<double, WIDTH>;
+        using columns = std::array<const char*, WIDTH>;
+
+        enum class format { csv, binary };
+
+        recorder(const columns& names) : m_columns{ names } {}
+
+        ~recorder()
+        {
+            stop();
+        }
+
+        recorder(const recorder&) = delete;
+        recorder& operator=(const recorder&) = delete;
+
+        bool start(const std::string& filename, const format fmt)
+        {
+            stop();
+
+            m_file.open(filename, fmt == format::csv ? std::ios::out : std::ios::out | std::ios::binary);
+            if (!m_file.is_open()) return false;
+            m_file.precision(std::numeric_limits<double>::max_digits10);
+
+            if (m_ring.empty()) m_ring.resize(CAPACITY); // allocated once, on first use
+
+            // the indices only ever grow: a push still finishing from before stop() may store its
+            // head + 1 at any moment, so start the new file from wherever the head has got to
+            m_first = m_head.load(std::memory_order_acquire);
+            m_tail.store(m_first, std::memory_order_relaxed);
+            m_dropped.store(0, std::memory_order_relaxed);
+            m_format = fmt;
+
+            if (m_format == format::csv)
+            {
+                for (size_t column{}; column < WIDTH; ++column)
+                {
+                    m_file << m_columns[column] << (column + 1 < WIDTH ? ',' : '\n');
+                }
+            }
+
+            m_running.store(true, std::memory_order_release);
+            m_writer = std::thread{ &recorder::drain, this };
+            return true;
+        }
+
+        void stop()
+        {
+            if (!m_writer.joinable()) return;
+
+            m_running.store(false, std::memory_order_release);
+            m_writer.join();
+            m_file.close();
+        }
+
+        bool recording() const
+        {
+            return m_running.load(std::memory_order_acquire);
+        }
+
+        /// Append one frame. Never blocks or allocates; returns false if the frame was dropped.
+        template <typename... VALUES>
+        bool push(const VALUES... values)
+        {
+            static_assert(sizeof...(VALUES) == WIDTH, "recorder::push needs one value per column");
+
+            if (!recording()) return false;
+
+            const size_t head{ m_head.load(std::memory_order_relaxed) };
+            if (head - m_tail.load(std::memory_order_acquire) >= CAPACITY)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            m_ring[head & (CAPACITY - 1)] = frame{ static_cast<double>(values)... };
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Frames dropped because the ring was full, since the last start(). Still valid after stop().
+        size_t dropped() const
+        {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+        /// Frames accepted for writing since the last start(). Still valid after stop().
+        size_t recorded() const
+        {
+            return m_head.load(std::memory_order_relaxed) - m_first;
+        }
+
+    private:
+        void drain()
+        {
+            bool running{ true };
+
+            while (running)
+            {
+                // read the flag before the ring so that the last frames pushed before stop() are written
+                running = recording();
+
+                const size_t head{ m_head.load(std::memory_order_acquire) };
+                size_t tail{ m_tail.load(std::memory_order_relaxed) };
+
+                if (head == tail)
+                {
+                    if (running) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    continue;
+                }
+
+                for (; tail != head; ++tail)
+                {
+                    write(m_ring[tail & (CAPACITY - 1)]);
+                }
+                m_tail.store(tail, std::memory_order_release);
+            }
+
+            m_file.flush();
+        }
+
+        void write(const frame& f)
+        {
+            if (m_format == format::binary)
+            {
+                m_file.write(reinterpret_cast<const char*>(f.data()), sizeof(frame));
+            }
+            else
+            {
+                for (size_t column{}; column < WIDTH; ++column)
+                {
+                    m_file << f[column] << (column + 1 < WIDTH ? ',' : '\n');
+                }
+            }
+        }
+
+        const columns m_columns;
+        std::vector<frame> m_ring{};
+        std::atomic<size_t> m_head{ 0 };
+        std::atomic<size_t> m_tail{ 0 };
+        std::atomic<size_t> m_dropped{ 0 };
+        size_t m_first{};
+        std::atomic<bool> m_running{ false };
+        format m_format{ format::csv };
+        std::ofstream m_file{};
+        std::thread m_writer{};
+    };
+
+    /// Convert a Max path (e.g. "Macintosh HD:/Users/me/pit.csv") to one the C++ library can open.
+    inline std::string native_path(const c74::min::symbol& maxpath)
+    {
+        char native[MAX_PATH_CHARS]{};
+        if (c74::max::path_nameconform(maxpath.c_str(), native, c74::max::PATH_STYLE_NATIVE, c74::max::PATH_TYPE_BOOT) != 0)
+        {
+            return maxpath.c_str();
+        }
+        return native;
+    }
+
+    /// Handle the arguments of a "record" message: a Max-style path and an optional format
+    /// (csv or binary) start a recording, anything else stops it. Without a format, files
+    /// ending in .csv are written as text. Stopping a recording posts how many frames it got
+    /// to log, and warns if any were dropped. Returns false if the file could not be opened.
+    template <typename RECORDER, typename LOG>
+    bool record_message(RECORDER& rec, const c74::min::atoms& args, LOG& log)
+    {
+        if (rec.recording())
+        {
+            rec.stop();
+            log << "recorded " << rec.recorded() << " frames";
+            if (rec.dropped() > 0) log << ", dropped " << rec.dropped() << " because the disk fell behind";
+            log << c74::min::endl;
+        }
+
+        if (args.empty() || args[0].a_type != c74::max::A_SYM) return true;
+
+        const std::string filename{ native_path(args[0]) };
+
+        typename RECORDER::format fmt{ RECORDER::format::binary };
+        if (args.size() > 1) fmt = (c74::min::symbol(args[1]) == "csv") ? RECORDER::format::csv : RECORDER::format::binary;
+        else if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0) fmt = RECORDER::format::csv;
+
+        return rec.start(filename, fmt);
+    }
+}
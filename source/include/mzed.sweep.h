@@ -0,0 +1,203 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "c74_min.h"
+#include "mzed.point.h"
+#include "mzed.events.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace mzed
+{
+    /// sweep <coefficient> <from> <to> <count> [steps] [transient]
+    struct sweep_settings
+    {
+        double from;
+        double to;
+        int count;
+        int steps;
+        int transient;
+    };
+
+    /// What one integration of a sweep settled into once its transient was discarded.
+    struct sweep_run
+    {
+        double value{};             ///< the swept coefficient
+        point minimum{};
+        point maximum{};
+        std::vector<double> maxima{}; ///< local maxima of the section axis, in order
+        int cycle{};                ///< maxima per repeat of the orbit; 0 for chaos or a fixed point
+        double period{};            ///< duration of one repeat in steps; 0 when cycle is 0
+        bool diverged{};
+    };
+
+    constexpr int sweep_max_cycle{ 16 };
+    constexpr double sweep_divergence{ 1e6 };
+
+    // A sweep runs in the message handler, so these keep the longest one to a fraction of a
+    // second on a few cores.
+    constexpr int sweep_max_count{ 1000 };
+    constexpr int sweep_max_steps{ 100000 };      ///< also the longest transient
+
+    /// Read the numeric part of a sweep message, or nothing if it doesn't describe a sweep.
+    /// count, steps and transient are capped at the limits above.
+    inline std::optional<sweep_settings> sweep_request(const c74::min::atoms& args)
+    {
+        if (args.size() < 4) return {};
+
+        const double count{ args[3] };
+        const double steps{ args.size() > 4 ? double(args[4]) : 10000.0 };
+        const double transient{ args.size() > 5 ? double(args[5]) : 5000.0 };
+        if (!(count >= 1) || !(steps >= 1) || !(transient >= 0)) return {};
+
+        return sweep_settings{ args[1], args[2], static_cast<int>(std::min<double>(count, sweep_max_count)), static_cast<int>(std::min<double>(steps, sweep_max_steps)),
+                               static_cast<int>(std::min<double>(transient, sweep_max_steps)) };
+    }
+
+    /// Integrate from start for one value of the swept coefficient. The axis'th coordinate is
+    /// sampled at its local maxima, as in the attractors' maxima events, and the maxima are
+    /// then searched for a repeating pattern.
+    template <typename COEFFICIENTS, typename STEP>
+    sweep_run sweep_one(const sweep_settings& settings, point p, COEFFICIENTS k, double COEFFICIENTS::*swept, const double value, const int axis, STEP& step)
+    {
+        sweep_run run{};
+        run.value = value;
+        k.*swept = value;
+
+        event_detector detector{};
+        std::vector<double> times{};
+
+        for (int n{}; n < settings.transient + settings.steps; ++n)
+        {
+            p = step(p, k);
+
+            if (!std::isfinite(p.x + p.y + p.z) || std::fabs(p.x) > sweep_divergence || std::fabs(p.y) > sweep_divergence || std::fabs(p.z) > sweep_divergence)
+            {
+                run.diverged = true;
+                run.maxima.clear();
+                return run;
+            }
+
+            const int settled{ n - settings.transient };
+
+            if (settled == 0)
+            {
+                run.minimum = p;
+                run.maximum = p;
+            }
+            else if (settled > 0)
+            {
+                run.minimum = { std::min(run.minimum.x, p.x), std::min(run.minimum.y, p.y), std::min(run.minimum.z, p.z) };
+                run.maximum = { std::max(run.maximum.x, p.x), std::max(run.maximum.y, p.y), std::max(run.maximum.z, p.z) };
+            }
+
+            point at{};
+            double ago{};
+            if (settled >= 0 && detector.next(p, events::maxima, axis, 0.0, at, ago))
+            {
+                run.maxima.push_back(coordinate(at, axis));
+                times.push_back(settled - ago);
+            }
+        }
+
+        const size_t found{ run.maxima.size() };
+        const double tolerance{ 1e-3 * (coordinate(run.maximum, axis) - coordinate(run.minimum, axis)) + 1e-9 };
+
+        for (size_t cycle{ 1 }; cycle <= sweep_max_cycle && 2 * cycle < found; ++cycle)
+        {
+            bool repeats{ true };
+            for (size_t i{ found - cycle }; i < found && repeats; ++i)
+            {
+                repeats = std::fabs(run.maxima[i] - run.maxima[i - cycle]) <= tolerance;
+            }
+
+            if (repeats)
+            {
+                run.cycle = static_cast<int>(cycle);
+                run.period = times[found - 1] - times[found - 1 - cycle];
+                break;
+            }
+        }
+
+        return run;
+    }
+
+    /// Integrate settings.count copies of an attractor, spreading the swept coefficient evenly
+    /// over [from, to], on as many threads as there are cores. Every copy starts from the same
+    /// point; step(point, coefficients) advances one copy by one timestep and must be reentrant.
+    template <typename COEFFICIENTS, typename STEP>
+    std::vector<sweep_run> sweep(const sweep_settings& settings, const point& start, const COEFFICIENTS& base, double COEFFICIENTS::*swept, const int axis, STEP step)
+    {
+        std::vector<sweep_run> runs(settings.count);
+        std::atomic<int> next{};
+
+        const auto work{ [&] {
+            for (int i{ next++ }; i < settings.count; i = next++)
+            {
+                const double value{ settings.count > 1 ? settings.from + (settings.to - settings.from) * i / (settings.count - 1) : settings.from };
+                runs[i] = sweep_one(settings, start, base, swept, value, axis, step);
+            }
+        } };
+
+        const unsigned cores{ std::max(1u, std::thread::hardware_concurrency()) };
+        std::vector<std::thread> workers{};
+        for (unsigned worker{ 1 }; worker < std::min(cores, static_cast<unsigned>(settings.count)); ++worker)
+        {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) worker.join();
+
+        return runs;
+    }
+
+    /// Fill a dictionary with the results of a sweep, one array entry per run (or, for the
+    /// bifurcation diagram, a flat list of value/maximum pairs ready for plotting).
+    inline void write_sweep(c74::min::dict& results, const c74::min::symbol& coefficient, const std::vector<sweep_run>& runs)
+    {
+        using namespace c74::min;
+
+        c74::max::t_dictionary* d{ results };
+        c74::max::dictionary_clear(d);
+        c74::max::dictionary_appendsym(d, symbol("coefficient"), coefficient);
+
+        const auto column{ [&](const char* key, const auto& field) {
+            atoms values{};
+            values.reserve(runs.size());
+            for (const auto& run : runs) values.push_back(field(run));
+            c74::max::dictionary_appendatoms(d, symbol(key), static_cast<long>(values.size()), &values[0]);
+        } };
+
+        column("value", [](const sweep_run& run) { return run.value; });
+        column("x_min", [](const sweep_run& run) { return run.minimum.x; });
+        column("x_max", [](const sweep_run& run) { return run.maximum.x; });
+        column("y_min", [](const sweep_run& run) { return run.minimum.y; });
+        column("y_max", [](const sweep_run& run) { return run.maximum.y; });
+        column("z_min", [](const sweep_run& run) { return run.minimum.z; });
+        column("z_max", [](const sweep_run& run) { return run.maximum.z; });
+        column("peaks", [](const sweep_run& run) { return static_cast<int>(run.maxima.size()); });
+        column("cycle", [](const sweep_run& run) { return run.cycle; });
+        column("period", [](const sweep_run& run) { return run.period; });
+        column("diverged", [](const sweep_run& run) { return static_cast<int>(run.diverged); });
+
+        atoms bifurcation{};
+        for (const auto& run : runs)
+        {
+            for (const double maximum : run.maxima)
+            {
+                bifurcation.push_back(run.value);
+                bifurcation.push_back(maximum);
+            }
+        }
+        if (!bifurcation.empty()) c74::max::dictionary_appendatoms(d, symbol("bifurcation"), static_cast<long>(bifurcation.size()), &bifurcation[0]);
+    }
+}
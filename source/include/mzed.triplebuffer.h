@@ -0,0 +1,68 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace mzed
+{
+    /// Hands the latest version of a value from one writer thread to one reader thread without
+    /// locks or allocation. The writer fills back() and calls publish(); the reader calls
+    /// update() and reads front(). Neither ever waits for the other: the third buffer in the
+    /// middle always holds the newest complete value, and versions the reader didn't get round
+    /// to are simply skipped.
+    template <typename T>
+    class triple_buffer
+    {
+    public:
+        triple_buffer() = default;
+
+        explicit triple_buffer(const T& initial)
+        {
+            m_buffers.fill(initial);
+        }
+
+        triple_buffer(const triple_buffer&) = delete;
+        triple_buffer& operator=(const triple_buffer&) = delete;
+
+        /// Writer: the buffer to fill. It holds whatever was last swapped into it, not
+        /// necessarily the last value published.
+        T& back()
+        {
+            return m_buffers[m_back];
+        }
+
+        /// Writer: make back() the newest value and take another buffer to write into.
+        void publish()
+        {
+            m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & index;
+        }
+
+        /// Reader: swap in the newest value if one was published since the last update.
+        bool update()
+        {
+            if ((m_middle.load(std::memory_order_relaxed) & fresh) == 0) return false;
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index;
+            return true;
+        }
+
+        /// Reader: the value picked up by the last update().
+        const T& front() const
+        {
+            return m_buffers[m_front];
+        }
+
+    private:
+        static constexpr int index{ 3 };
+        static constexpr int fresh{ 4 };
+
+        std::array<T, 3> m_buffers{};
+        int m_back{ 0 };
+        std::atomic<int> m_middle{ 1 };
+        int m_front{ 2 };
+    };
+}
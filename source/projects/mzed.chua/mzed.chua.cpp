@@ -4,9 +4,59 @@
 ///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
 
 #include "c74_min.h"
+#include "mzed.attractor.h"
 
 using namespace c74::min;
 
+/// Chua's circuit, stepped by mzed::attractor.
+struct chua_equations
+{
+  struct coefficients
+  {
+    double a;
+    double b;
+    double c;
+    double d;
+    double e;
+    double h;
+  };
+
+  static constexpr int sweep_axis { 0 };
+
+  /// The coefficient a sweep message names, or nullptr if it can't be swept.
+  static double coefficients::*sweepable(const symbol& name)
+  {
+    if (name == symbol("a")) return &coefficients::a;
+    if (name == symbol("b")) return &coefficients::b;
+    if (name == symbol("c")) return &coefficients::c;
+    if (name == symbol("d")) return &coefficients::d;
+    if (name == symbol("e")) return &coefficients::e;
+    return nullptr;
+  }
+
+  /// One Euler step of Chua's circuit, with the derivatives evaluated in REAL.
+  template <typename REAL>
+  static mzed::point step(const mzed::point& p, const coefficients& k)
+  {
+    const REAL x { static_cast<REAL>(p.x) };
+    const REAL y { static_cast<REAL>(p.y) };
+    const REAL z { static_cast<REAL>(p.z) };
+    const REAL a { static_cast<REAL>(k.a) };
+    const REAL b { static_cast<REAL>(k.b) };
+    const REAL c { static_cast<REAL>(k.c) };
+    const REAL d { static_cast<REAL>(k.d) };
+    const REAL e { static_cast<REAL>(k.e) };
+    const REAL h { static_cast<REAL>(k.h) };
+
+    const REAL g { (e * x) + (d + e) * (std::fabs(x + 1) - std::fabs(x - 1)) };
+    return {
+      p.x + (h * a * (y - x - g)),
+      p.y + (h * b * (x - y + z)),
+      p.z + (h * -c * y)
+    };
+  }
+};
+
 class mzed_chua : public object<mzed_chua>
 {
 public:
@@ -19,6 +69,9 @@ public:
   outlet<> outlet_x { this, "(float) x coordinate" };
   outlet<> outlet_y { this, "(float) y coordinate" };
   outlet<> outlet_z { this, "(float) z coordinate" };
+  outlet<> dumpout  { this, "stats and sweep results" };
+
+  mzed::attractor<chua_equations> attractor { outlet_x, outlet_y, outlet_z, dumpout, { 1.0, 1.0, 1.0 } };
 
   attribute<double> c_a { this, "a", 14.5 };
   attribute<double> c_b { this, "b", 1.0 };
@@ -26,6 +79,14 @@ public:
   attribute<double> c_d { this, "d", -1.0 }; // -8/7 -1.14285714286
   attribute<double> c_e { this, "e", 0.0 }; // -5/7 -0.714285714286
   attribute<double> c_h { this, "timestep (h)", 0.01 };
+  attribute<mzed::precisions> precision { this, "precision", mzed::precisions::double_precision, mzed::precision_range,
+    description { "Arithmetic used for each step: double, or float derivatives accumulated in double. Float is for hearing single-precision rounding in the trajectory, not for speed: converting to float and back on every step makes it slower than double." } };
+  attribute<mzed::events> event_mode { this, "events", mzed::events::off, mzed::event_range,
+    description { "What a bang outputs: the next step (off), or the point of the next upward crossing of the section, maximum or minimum along the event axis, integrating as many steps as it takes." } };
+  attribute<mzed::axes> event_axis { this, "axis", mzed::axes::x, mzed::axis_range,
+    description { "Coordinate watched for events." } };
+  attribute<double> event_section { this, "section", 0.0,
+    description { "Value of the event axis whose upward crossings are events in crossing mode." } };
 
   argument<number> a_arg { this, "a", "Initial a value.", MIN_ARGUMENT_FUNCTION { c_a = arg; } };
   argument<number> b_arg { this, "b", "Initial b value.", MIN_ARGUMENT_FUNCTION { c_b = arg; } };
@@ -34,27 +95,58 @@ public:
   argument<number> e_arg { this, "e", "Initial e value.", MIN_ARGUMENT_FUNCTION { c_e = arg; } };
   argument<number> h_arg { this, "h", "Initial h (timestep) value.", MIN_ARGUMENT_FUNCTION { c_h = arg; } };
 
+  /// The coefficients as the attributes have them now.
+  chua_equations::coefficients coefficients_now() const
+  {
+    return { c_a, c_b, c_c, c_d, c_e, c_h };
+  }
+
   message<> bang
   {
     this, "bang", "Calculate the next point.",
     MIN_FUNCTION
     {
-      // calculate the attractor
-      const double zNew { currentZ + (c_h * -c_c * currentY) };
-      const double yNew { currentY + (c_h * c_b * (currentX - currentY + currentZ)) };
-      const double g    { (c_e * currentX) + (c_d + c_e) * (fabs(currentX + 1) - fabs(currentX - 1)) };
-      const double xNew { currentX + (c_h * c_a * (currentY - currentX - g)) };
-      
-      // save the calculated values
-      currentX = xNew;
-      currentY = yNew;
-      currentZ = zNew;
-      
-      // output the calculated values
-      outlet_z.send(zNew);
-      outlet_y.send(yNew);
-      outlet_x.send(xNew);
-      
+      attractor.bang(coefficients_now(), precision.get(), event_mode.get(), event_axis.get(), event_section);
+      return {};
+    }
+  };
+  
+  message<> stats
+  {
+    this, "stats", "Report steps, steps/sec and messages sent since the last report, and frames dropped by the current or last recording, out the right outlet (plus ns per step when built with MZED_PROFILE).",
+    MIN_FUNCTION
+    {
+      attractor.stats();
+      return {};
+    }
+  };
+  
+  message<> sweep
+  {
+    this, "sweep", "Integrate many copies across a range of one coefficient on all cores, then put extrema, periods and a bifurcation diagram of x maxima in a dictionary named out the right outlet: sweep <a|b|c|d|e> <from> <to> <count> [steps] [transient]. Blocks until every run is done; count is capped at 1000, steps and transient at 100000.",
+    MIN_FUNCTION
+    {
+      if (!attractor.sweep(args, coefficients_now())) cerr << "usage: sweep <a|b|c|d|e> <from> <to> <count> [steps] [transient]" << endl;
+      return {};
+    }
+  };
+  
+  message<> allocations
+  {
+    this, "allocations", "Post the heap allocations counted in bang (debug builds with MZED_COUNT_ALLOCATIONS).",
+    MIN_FUNCTION
+    {
+      attractor.allocations(cout);
+      return {};
+    }
+  };
+  
+  message<> record
+  {
+    this, "record", "Stream every point sent out to a file: record <path> [csv|binary]. No path stops recording.",
+    MIN_FUNCTION
+    {
+      if (!attractor.record(args, cout)) cerr << "could not open file for recording" << endl;
       return {};
     }
   };
@@ -70,11 +162,7 @@ public:
       return {};
     }
   };
-  
-private:
-    double currentX { 1.0 };
-    double currentY { 1.0 };
-    double currentZ { 1.0 };
-    };
+
+};
 
 MIN_EXTERNAL(mzed_chua);
@@ -5,6 +5,7 @@
 
 #include "c74_min_unittest.h"     // required unit test header
 #include "mzed.chua.cpp"    // need the source of our object so that we can access it
+#include "mzed.benchmark.h"
 
 SCENARIO("object produces correct output")
 {
@@ -51,3 +52,110 @@ SCENARIO("object produces correct output")
     }
   }
 }
+
+// Reference points from the double-precision integration with default settings. Approx leaves
+// room for compilers that contract multiply-adds, which moves the last few bits.
+SCENARIO("trajectory matches golden data")
+{
+  ext_main(nullptr);
+
+  GIVEN("An instance of chua")
+  {
+    test_wrapper<mzed_chua> an_instance;
+    mzed_chua&              my_object = an_instance;
+
+    WHEN("1000 bangs are received")
+    {
+      for (int step {}; step < 1000; ++step) my_object.bang();
+
+      THEN("x follows the reference trajectory")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 0);
+        REQUIRE(output.size() == 1000);
+        REQUIRE(double(output[99][1]) == Approx(0.4869827752782839));
+        REQUIRE(double(output[999][1]) == Approx(-2.4574932218181633));
+      }
+      THEN("y follows the reference trajectory")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 1);
+        REQUIRE(output.size() == 1000);
+        REQUIRE(double(output[99][1]) == Approx(-0.44530829945841854));
+        REQUIRE(double(output[999][1]) == Approx(-0.6622550277583947));
+      }
+      THEN("z follows the reference trajectory")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 2);
+        REQUIRE(output.size() == 1000);
+        REQUIRE(double(output[99][1]) == Approx(3.5915144511814887));
+        REQUIRE(double(output[999][1]) == Approx(-0.39409631832323166));
+      }
+    }
+  }
+}
+
+// Running in float evaluates each derivative in single precision but keeps accumulating the
+// state in double. For the first few hundred steps that stays within 1e-4 of the double path;
+// after that the attractor's own sensitivity separates any two trajectories, so longer runs
+// are only comparable statistically.
+SCENARIO("single precision tracks the double path")
+{
+  ext_main(nullptr);
+
+  GIVEN("A double and a float instance of chua")
+  {
+    test_wrapper<mzed_chua> double_instance;
+    test_wrapper<mzed_chua> float_instance;
+    mzed_chua&              double_object = double_instance;
+    mzed_chua&              float_object = float_instance;
+
+    float_object.precision = mzed::precisions::single_precision;
+
+    WHEN("both are banged 300 times")
+    {
+      for (int step {}; step < 300; ++step)
+      {
+        double_object.bang();
+        float_object.bang();
+      }
+
+      THEN("x, y and z agree to within 1e-4")
+      {
+        for (int axis {}; axis < 3; ++axis)
+        {
+          auto& expected = *c74::max::object_getoutput(double_object, axis);
+          auto& actual = *c74::max::object_getoutput(float_object, axis);
+          REQUIRE(double(actual.back()[1]) == Approx(double(expected.back()[1])).epsilon(1e-4).margin(1e-4));
+        }
+      }
+    }
+  }
+}
+
+// Steps per second of chua_equations::step<double> alone, measured in Debug and Release
+// builds; see mzed.benchmark.h
+constexpr double baseline_steps_per_sec { mzed::baseline(55.0e6, 95.0e6) };
+
+SCENARIO("throughput does not regress")
+{
+  ext_main(nullptr);
+
+  GIVEN("The chua equations with the default coefficients")
+  {
+    test_wrapper<mzed_chua> an_instance;
+    mzed_chua&              my_object = an_instance;
+    const auto k { my_object.coefficients_now() };
+    mzed::point p { my_object.attractor.current };
+
+    WHEN("they are stepped 1000000 times")
+    {
+      const double rate { mzed::steps_per_second(1000000, [&] { p = chua_equations::step<double>(p, k); }) };
+
+      THEN("they keep up with the baseline")
+      {
+        WARN("chua: " << rate << " steps/sec");
+        REQUIRE(std::isfinite(p.x));
+        REQUIRE(mzed::meets_baseline(rate, baseline_steps_per_sec));
+      }
+    }
+  }
+}
@@ -4,9 +4,50 @@
 ///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
 
 #include "c74_min.h"
+#include "mzed.attractor.h"
 
 using namespace c74::min;
 
+/// The Lorenz equations, stepped by mzed::attractor.
+struct lorenz_equations
+{
+  // bang always uses the constants in mzed_lorenz; a sweep varies one of them
+  struct coefficients
+  {
+    double a;
+    double b;
+    double c;
+    double h;
+  };
+
+  static constexpr int sweep_axis { 2 };
+
+  /// The coefficient a sweep message names, or nullptr if it can't be swept.
+  static double coefficients::*sweepable(const symbol& name)
+  {
+    if (name == symbol("a")) return &coefficients::a;
+    if (name == symbol("b")) return &coefficients::b;
+    if (name == symbol("c")) return &coefficients::c;
+    return nullptr;
+  }
+
+  /// One Euler step of the Lorenz equations, with the derivatives evaluated in REAL.
+  template <typename REAL>
+  static mzed::point step(const mzed::point& p, const coefficients& k)
+  {
+    const REAL x{ static_cast<REAL>(p.x) };
+    const REAL y{ static_cast<REAL>(p.y) };
+    const REAL z{ static_cast<REAL>(p.z) };
+    const REAL h{ static_cast<REAL>(k.h) };
+
+    return {
+      p.x + ((h * static_cast<REAL>(k.b)) * (y - x)),
+      p.y + (h * ((static_cast<REAL>(k.a) * x - y) - (x * z))),
+      p.z + (h * ((x * y) - (static_cast<REAL>(k.c) * z)))
+    };
+  }
+};
+
 class mzed_lorenz : public object<mzed_lorenz>
 {
 public:
@@ -23,12 +64,23 @@ public:
   outlet<> outlet_x { this, "(float) x coordinate" };
   outlet<> outlet_y { this, "(float) y coordinate" };
   outlet<> outlet_z { this, "(float) z coordinate" };
+  outlet<> dumpout  { this, "stats and sweep results" };
+
+  mzed::attractor<lorenz_equations> attractor { outlet_x, outlet_y, outlet_z, dumpout, { 0.6, 0.6, 0.6 } };
 
   attribute<double> l_h { this, "timestep (h)", 0.01 };
+  attribute<mzed::precisions> precision { this, "precision", mzed::precisions::double_precision, mzed::precision_range,
+    description { "Arithmetic used for each step: double, or float derivatives accumulated in double. Float is for hearing single-precision rounding in the trajectory, not for speed: converting to float and back on every step makes it slower than double." } };
+  attribute<mzed::events> event_mode { this, "events", mzed::events::off, mzed::event_range,
+    description { "What a bang outputs: the next step (off), or the point of the next upward crossing of the section, maximum or minimum along the event axis, integrating as many steps as it takes." } };
+  attribute<mzed::axes> event_axis { this, "axis", mzed::axes::z, mzed::axis_range,
+    description { "Coordinate watched for events." } };
+  attribute<double> event_section { this, "section", 27.0,
+    description { "Value of the event axis whose upward crossings are events in crossing mode." } };
   
-  argument<number> x_arg { this, "x", "Initial x value.", MIN_ARGUMENT_FUNCTION { currentX = arg; } };
-  argument<number> y_arg { this, "y", "Initial y value.", MIN_ARGUMENT_FUNCTION { currentY = arg; } };
-  argument<number> z_arg { this, "z", "Initial z value.", MIN_ARGUMENT_FUNCTION { currentZ = arg; } };
+  argument<number> x_arg { this, "x", "Initial x value.", MIN_ARGUMENT_FUNCTION { attractor.current.x = arg; } };
+  argument<number> y_arg { this, "y", "Initial y value.", MIN_ARGUMENT_FUNCTION { attractor.current.y = arg; } };
+  argument<number> z_arg { this, "z", "Initial z value.", MIN_ARGUMENT_FUNCTION { attractor.current.z = arg; } };
 
   argument<number> h_arg { this, "h", "Initial h (timestep) value.", MIN_ARGUMENT_FUNCTION { l_h = arg; } };
 
@@ -40,13 +92,13 @@ public:
       switch (inlet)
       {
         case 0:
-          currentX = args[0];
+          attractor.set(0, args[0]);
           return {};
         case 1:
-          currentY = args[0];
+          attractor.set(1, args[0]);
           return {};
         case 2:
-          currentZ = args[0];
+          attractor.set(2, args[0]);
           return {};
         default:
           assert(false);
@@ -56,25 +108,58 @@ public:
     }
   };
   
+  /// The coefficients as the attributes have them now.
+  lorenz_equations::coefficients coefficients_now() const
+  {
+    return { LorenzA, LorenzB, LorenzC, l_h };
+  }
+
   message<> bang
   {
     this, "bang", "Calculate the next point.",
     MIN_FUNCTION
     {
-      // calculate the attractor
-      const double zNew { currentZ + (l_h * ((currentX * currentY) - (LorenzC * currentZ))) };
-      const double yNew { currentY + (l_h * ((LorenzA * currentX - currentY) - (currentX * currentZ))) };
-      const double xNew { currentX + ((l_h * LorenzB) * (currentY - currentX)) };
-      
-      // save the calculated values
-      currentX = xNew;
-      currentY = yNew;
-      currentZ = zNew;
-      
-      // output the calculated values
-      outlet_z.send(zNew);
-      outlet_y.send(yNew);
-      outlet_x.send(xNew);
+      attractor.bang(coefficients_now(), precision.get(), event_mode.get(), event_axis.get(), event_section);
+      return {};
+    }
+  };
+  
+  message<> stats
+  {
+    this, "stats", "Report steps, steps/sec and messages sent since the last report, and frames dropped by the current or last recording, out the right outlet (plus ns per step when built with MZED_PROFILE).",
+    MIN_FUNCTION
+    {
+      attractor.stats();
+      return {};
+    }
+  };
+  
+  message<> sweep
+  {
+    this, "sweep", "Integrate many copies across a range of one coefficient on all cores, then put extrema, periods and a bifurcation diagram of z maxima in a dictionary named out the right outlet: sweep <a|b|c> <from> <to> <count> [steps] [transient]. Blocks until every run is done; count is capped at 1000, steps and transient at 100000.",
+    MIN_FUNCTION
+    {
+      if (!attractor.sweep(args, coefficients_now())) cerr << "usage: sweep <a|b|c> <from> <to> <count> [steps] [transient]" << endl;
+      return {};
+    }
+  };
+  
+  message<> allocations
+  {
+    this, "allocations", "Post the heap allocations counted in bang (debug builds with MZED_COUNT_ALLOCATIONS).",
+    MIN_FUNCTION
+    {
+      attractor.allocations(cout);
+      return {};
+    }
+  };
+  
+  message<> record
+  {
+    this, "record", "Stream every point sent out to a file: record <path> [csv|binary]. No path stops recording.",
+    MIN_FUNCTION
+    {
+      if (!attractor.record(args, cout)) cerr << "could not open file for recording" << endl;
       return {};
     }
   };
@@ -91,10 +176,6 @@ public:
   };
   
 private:
-    double currentX{ 0.6 };
-    double currentY{ 0.6 };
-    double currentZ{ 0.6 };
-
     // Constants from Lorenz equation
     static constexpr double LorenzA{ 28.0 };
     static constexpr double LorenzB{ 10.0 };
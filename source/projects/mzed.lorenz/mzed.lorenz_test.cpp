@@ -5,6 +5,7 @@
 
 #include "c74_min_unittest.h"     // required unit test header
 #include "mzed.lorenz.cpp"    // need the source of our object so that we can access it
+#include "mzed.benchmark.h"
 
 SCENARIO("object produces correct output")
 {
@@ -47,3 +48,211 @@ SCENARIO("object produces correct output")
     }
   }
 }
+
+SCENARIO("stats are reported")
+{
+  ext_main(nullptr);
+
+  GIVEN("An instance of lorenz")
+  {
+    test_wrapper<mzed_lorenz> an_instance;
+    mzed_lorenz&              my_object = an_instance;
+
+    WHEN("10 bangs are followed by 'stats'")
+    {
+      for (int step {}; step < 10; ++step) my_object.bang();
+      my_object.stats();
+
+      THEN("the step and message counts come out of the dumpout")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 3);
+        REQUIRE(output.size() >= 3);
+        REQUIRE(output[0][1] == symbol("steps"));
+        REQUIRE(output[0][2] == 10.0);
+        REQUIRE(output[2][1] == symbol("messages_sent"));
+        REQUIRE(output[2][2] == 30.0);
+      }
+    }
+  }
+}
+
+// Reference points from the double-precision integration with default settings. Approx leaves
+// room for compilers that contract multiply-adds, which moves the last few bits.
+SCENARIO("trajectory matches golden data")
+{
+  ext_main(nullptr);
+
+  GIVEN("An instance of lorenz")
+  {
+    test_wrapper<mzed_lorenz> an_instance;
+    mzed_lorenz&              my_object = an_instance;
+
+    WHEN("1000 bangs are received")
+    {
+      for (int step {}; step < 1000; ++step) my_object.bang();
+
+      THEN("x follows the reference trajectory")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 0);
+        REQUIRE(output.size() == 1000);
+        REQUIRE(double(output[99][1]) == Approx(-3.5443930199259803));
+        REQUIRE(double(output[999][1]) == Approx(-5.799122044906934));
+      }
+      THEN("y follows the reference trajectory")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 1);
+        REQUIRE(output.size() == 1000);
+        REQUIRE(double(output[99][1]) == Approx(-4.551581668625955));
+        REQUIRE(double(output[999][1]) == Approx(-7.314174021991427));
+      }
+      THEN("z follows the reference trajectory")
+      {
+        auto& output = *c74::max::object_getoutput(my_object, 2);
+        REQUIRE(output.size() == 1000);
+        REQUIRE(double(output[99][1]) == Approx(18.97160015655222));
+        REQUIRE(double(output[999][1]) == Approx(21.09349737044874));
+      }
+    }
+  }
+}
+
+// Running in float evaluates each derivative in single precision but keeps accumulating the
+// state in double. For the first few hundred steps that stays within 1e-4 of the double path;
+// after that the attractor's own sensitivity separates any two trajectories, so longer runs
+// are only comparable statistically.
+SCENARIO("single precision tracks the double path")
+{
+  ext_main(nullptr);
+
+  GIVEN("A double and a float instance of lorenz")
+  {
+    test_wrapper<mzed_lorenz> double_instance;
+    test_wrapper<mzed_lorenz> float_instance;
+    mzed_lorenz&              double_object = double_instance;
+    mzed_lorenz&              float_object = float_instance;
+
+    float_object.precision = mzed::precisions::single_precision;
+
+    WHEN("both are banged 300 times")
+    {
+      for (int step {}; step < 300; ++step)
+      {
+        double_object.bang();
+        float_object.bang();
+      }
+
+      THEN("x, y and z agree to within 1e-4")
+      {
+        for (int axis {}; axis < 3; ++axis)
+        {
+          auto& expected = *c74::max::object_getoutput(double_object, axis);
+          auto& actual = *c74::max::object_getoutput(float_object, axis);
+          REQUIRE(double(actual.back()[1]) == Approx(double(expected.back()[1])).epsilon(1e-4).margin(1e-4));
+        }
+      }
+    }
+  }
+}
+
+// In maxima mode a bang integrates to the next local maximum of z and reports the vertex of a
+// parabola through the samples around it, so each event sits at or just above the largest
+// sample of the same peak in the step-by-step output.
+SCENARIO("maxima events follow the peaks of z")
+{
+  ext_main(nullptr);
+
+  GIVEN("A stepping and an event-driven instance of lorenz")
+  {
+    test_wrapper<mzed_lorenz> step_instance;
+    test_wrapper<mzed_lorenz> event_instance;
+    mzed_lorenz&              step_object = step_instance;
+    mzed_lorenz&              event_object = event_instance;
+
+    event_object.event_mode = mzed::events::maxima;
+
+    WHEN("the stepping one is banged 2000 times and the other 10 times")
+    {
+      for (int step {}; step < 2000; ++step) step_object.bang();
+      for (int event {}; event < 10; ++event) event_object.bang();
+
+      THEN("the events are the first 10 peaks of z")
+      {
+        auto& steps = *c74::max::object_getoutput(step_object, 2);
+        auto& events = *c74::max::object_getoutput(event_object, 2);
+        REQUIRE(events.size() == 10);
+
+        size_t event {};
+        for (size_t i { 1 }; i + 1 < steps.size() && event < events.size(); ++i)
+        {
+          const double z { steps[i][1] };
+          if (z > double(steps[i - 1][1]) && z >= double(steps[i + 1][1]))
+          {
+            REQUIRE(double(events[event][1]) >= z);
+            REQUIRE(double(events[event][1]) == Approx(z).margin(0.1));
+            ++event;
+          }
+        }
+        REQUIRE(event == events.size());
+      }
+
+      THEN("only the events are counted as messages")
+      {
+        event_object.stats();
+        auto& output = *c74::max::object_getoutput(event_object, 3);
+        REQUIRE(output[2][1] == symbol("messages_sent"));
+        REQUIRE(output[2][2] == 30.0);
+        REQUIRE(double(output[0][2]) > 100.0);
+      }
+    }
+  }
+
+  GIVEN("An event detector watching for maxima of z")
+  {
+    mzed::event_detector detector {};
+    mzed::point          at {};
+    double               ago {};
+
+    WHEN("it is switched to y between three points that peak in y")
+    {
+      REQUIRE_FALSE(detector.next({ 0.0, 0.0, 0.0 }, mzed::events::maxima, 2, 0.0, at, ago));
+      REQUIRE_FALSE(detector.next({ 0.0, 1.0, 1.0 }, mzed::events::maxima, 2, 0.0, at, ago));
+
+      THEN("the peak of y at the second point is not reported, but later ones are")
+      {
+        REQUIRE_FALSE(detector.next({ 0.0, 0.5, 2.0 }, mzed::events::maxima, 1, 0.0, at, ago));
+        REQUIRE_FALSE(detector.next({ 0.0, 1.0, 3.0 }, mzed::events::maxima, 1, 0.0, at, ago));
+        REQUIRE(detector.next({ 0.0, 0.0, 4.0 }, mzed::events::maxima, 1, 0.0, at, ago));
+        REQUIRE(at.y == Approx(1.0).margin(0.5));
+      }
+    }
+  }
+}
+
+// Steps per second of lorenz_equations::step<double> alone, measured in Debug and Release
+// builds; see mzed.benchmark.h
+constexpr double baseline_steps_per_sec { mzed::baseline(85.0e6, 140.0e6) };
+
+SCENARIO("throughput does not regress")
+{
+  ext_main(nullptr);
+
+  GIVEN("The lorenz equations with the default coefficients")
+  {
+    test_wrapper<mzed_lorenz> an_instance;
+    mzed_lorenz&              my_object = an_instance;
+    const auto k { my_object.coefficients_now() };
+    mzed::point p { my_object.attractor.current };
+
+    WHEN("they are stepped 1000000 times")
+    {
+      const double rate { mzed::steps_per_second(1000000, [&] { p = lorenz_equations::step<double>(p, k); }) };
+
+      THEN("they keep up with the baseline")
+      {
+        WARN("lorenz: " << rate << " steps/sec");
+        REQUIRE(std::isfinite(p.x));
+        REQUIRE(mzed::meets_baseline(rate, baseline_steps_per_sec));
+      }
+    }
+  }
+}
@@ -4,20 +4,39 @@
 ///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.e.
 
 #include "c74_min.h"
+#include "mzed.allocations.h"
+#include "mzed.moshpit.shared.h"
+#include "mzed.moshpit.sim.h"
+#include "mzed.parameters.h"
+#include "mzed.precision.h"
+#include "mzed.profiler.h"
+#include "mzed.recorder.h"
+#include "mzed.triplebuffer.h"
+
+#include <numeric>
 
 using namespace c74::min;
 using namespace c74::min::ui;
 
-constexpr size_t ARRAY_SIZE{ 1024 };
-constexpr size_t NMAX{ 50 };
-constexpr double RADIUS{ 1.0 };
-constexpr size_t TWO_R{ 2 };
-constexpr size_t FR{ 2 };
-constexpr double VHAPPY{ 1.0 };
-constexpr double DAMP{ 1.0 };
-constexpr double GDT{ 0.1 };
+constexpr size_t MAX_VOICES{ 256 };
+
+/// Where the moshers followed by the multichannel outlet were after one drawing frame, as
+/// x, y and force (each 0-1) for every voice, handed from the simulation to the audio thread.
+struct voice_frame
+{
+    std::array<double, 3 * MAX_VOICES> values{};
+    double seconds{};   ///< time until the next frame is expected
+};
+
+/// The fields added by the field message, in the coordinates out2 uses. Handed to the step
+/// through a parameter_block, so field and clearfields can come from any thread.
+struct view_fields
+{
+    std::array<moshpit_field, MAX_FIELDS> fields{};
+    size_t count{};
+};
 
-class mzed_moshpit : public object<mzed_moshpit>, public ui_operator<200, 200>
+class mzed_moshpit : public object<mzed_moshpit>, public ui_operator<200, 200>, public mc_operator<>
 {
 public:
     MIN_DESCRIPTION{ "A two-dimensional model of moshers, similar to a disordered gas." };
@@ -28,60 +47,86 @@ public:
     inlet<>  input{ this, "toggle on/off, reset" };
     outlet<> out1{ this, "position of yellow mosher" };
     outlet<> out2{ this, "all of the moshers, by type" };
+    outlet<> signals{ this, "(multichannelsignal) x, y and force of each voice", "multichannelsignal" };
+    outlet<> dumpout{ this, "stats and query replies" };
 
     mzed_moshpit(const atoms& args = {}) : ui_operator::ui_operator{ this, args }
     {
-        // calculate sidelength
-        lx = 1.03 * sqrt(M_PI * RADIUS * RADIUS * numMoshers);
-        ly = lx;
+        std::iota(m_selection.begin(), m_selection.end(), 0);
 
-        //neighborlist
-        m_size[0] = lx / FR;
-        m_size[1] = ly / FR;
+        // the name and on setters leave these to us until everything they use has been made
+        m_constructed = true;
+        attach(name);
+        if (on) clock.delay(0.0);
+        listen(on);
+    }
 
-        cells.resize((m_size[0] * m_size[1] * NMAX * 10), 0); //TODO: big should this be?
-        count.fill(0);
+    ~mzed_moshpit()
+    {
+        listen(false);
+    }
 
-        // init_circle(x);
-        bool uniq{ true };
+    /// Advance the simulation by one drawing frame (frameSkip particle frames), scattering a
+    /// new crowd first if numMoshers or fractionRed has changed, and send the frame out out1
+    /// and out2. Called by the clock and by bang, never by paint, so the outlets keep moving
+    /// while the view is hidden and each frame goes out once however often it's drawn. A view
+    /// of a shared pit instead picks up the newest frame stepped by the pit's owner thread.
+    /// Either way the attributes are read once, here, so a frame never mixes old and new
+    /// settings; a shared pit gets them through a parameter_block.
+    void step()
+    {
+        take_fields();
 
-        for (size_t mosher{}; mosher < numMoshers; ++mosher)
+        if (m_pit)
         {
-            const double tx{ lx * normRand() };
-            const double ty{ ly * normRand() };
+            sync_settings();
+            if (m_pit->read(m_snapshot))
+            {
+                arrived();
+                send_frame();
+            }
+            return;
+        }
 
-            type[mosher] = 0;
-            r[mosher] = RADIUS;
-            mpX[mosher] = tx;
-            mpY[mosher] = ty;
+        const moshpit_settings wanted{ settings() };
+        if (rescatters(m_applied, wanted)) init_pit(wanted);
 
-            const double dd{ sqrt((tx - lx / 2) * (tx - lx / 2) + (ty - ly / 2) * (ty - ly / 2)) };
-            const double rad{ sqrt(fractionRed * lx * ly / M_PI) };
-            const bool doCircle{ true };
+        m_crowd.step(wanted.params, wanted.frameskip, wanted.precision);
+        m_applied = wanted;
+        m_crowd.snapshot(m_snapshot);
+        arrived();
+        send_frame();
+    }
 
-            if (doCircle) // Expose this as an attribute?
-            {
-                if (dd < rad)
-                {
-                    type[mosher] = (uniq) ? 2 : 1;
-                    uniq = false;
-                }
-            }
-            else
-            {
-                if (normRand() < fractionRed) type[mosher] = 1;
-            }
+    /// Position of one mosher in simulation units, where the pit is side() units square.
+    std::array<double, 2> position(const size_t mosher) const
+    {
+        return { m_snapshot.x[mosher], m_snapshot.y[mosher] };
+    }
 
-            vx[mosher] = VHAPPY * (normRand() - 0.5);
-            vy[mosher] = VHAPPY * (normRand() - 0.5);
-        }
+    double side() const
+    {
+        return m_snapshot.side;
+    }
+
+    /// Allocations counted in the simulation's update and in drawing, with MZED_COUNT_ALLOCATIONS.
+    const mzed::allocation_counter& update_allocations() const
+    {
+        return m_snapshot.counters.updateAllocations;
+    }
+
+    const mzed::allocation_counter& draw_allocations() const
+    {
+        return m_drawAllocations;
     }
 
-    timer<> clock
+    // delivered on the main thread, like paint and the queries that read the same snapshot
+    timer<timer_options::defer_delivery> clock
     {
       this,
       MIN_FUNCTION
       {
+        step();
         redraw();
         const double interval { double(floor(1000 / framerate)) };
         clock.delay(interval);
@@ -90,6 +135,12 @@ public:
     };
 
 
+private:
+    // min calls the attribute setters while the object is still being made, before the state
+    // below them exists; set at the end of the constructor
+    bool m_constructed{};
+
+public:
     //////////////////////////////////////////////////////////////    attributes
 
     attribute<bool> on
@@ -100,20 +151,23 @@ public:
       {
         MIN_FUNCTION
         {
+          if (!m_constructed) return args;
+
           if (args[0] == true) clock.delay(0.0);    // fire the first one straight-away
           else clock.stop();
 
+          listen(args[0] == true);
           return args;
         }
       }
     };
 
-    attribute<int> numMoshers  //TODO: Threadsafe?
+    attribute<int> numMoshers
     {
       this, "numMoshers", 300,
       title { "number of moshers" },
-      description { "How many moshers (active and passive) in the pit." },
-      range { 1, 8192 }
+      description { "How many moshers (active and passive) in the pit. Changing it scatters a new crowd." },
+      range { 1, 16384 }
     };
 
     attribute<double> noise
@@ -131,7 +185,7 @@ public:
     attribute<double> fractionRed
     {
       this, "fractionRed", 0.15,
-      description { "Proportion of active moshers." }
+      description { "Proportion of active moshers. Changing it scatters a new crowd." }
     };
 
     attribute<int> frameskip
@@ -148,6 +202,33 @@ public:
       description { "Frequency of redrawing."}
     };
 
+    attribute<int> voices
+    {
+      this, "voices", 8,
+      description { "How many moshers the multichannel outlet follows, with x, y and force channels for each. Takes effect when audio is restarted." },
+      range { 1, static_cast<int>(MAX_VOICES) }
+    };
+
+    attribute<mzed::precisions> precision
+    {
+      this, "precision", mzed::precisions::double_precision, mzed::precision_range,
+      description { "Arithmetic for the particle physics: double, or float for half the memory traffic per step." }
+    };
+
+    attribute<symbol> name
+    {
+      this, "name", "",
+      description { "Share one simulation with every mzed.moshpit of the same name, stepped once however many there are. Each still draws it at its own size and with its own showForce and draw settings; changing any other attribute changes the shared pit. Empty for a pit of its own." },
+      setter
+      {
+        MIN_FUNCTION
+        {
+          if (m_constructed) attach(args[0]);
+          return args;
+        }
+      }
+    };
+
     attribute<bool> showForce
     {
       this, "showForce", false,
@@ -164,7 +245,12 @@ public:
 
     //////////////////////////////////////////////////////////////    messages
 
-    message<> toggle
+    // The messages that step, scatter, query or report on the crowd, or change which moshers
+    // the outlet follows, are marked threadsafe::no: min defers any that arrive on another
+    // thread to the main thread, where the clock steps and paint draws. field and clearfields
+    // reach the step through a parameter_block instead.
+
+    message<threadsafe::no> toggle
     {
       this, "int", "Turn on/off the internal timer.",
       MIN_FUNCTION
@@ -174,16 +260,32 @@ public:
       }
     };
 
-    message<> bang
+    message<threadsafe::no> bang
     {
-      this, "bang", "redraw",
+      this, "bang", "Step one frame and redraw.",
       MIN_FUNCTION
       {
+        step();
         redraw();
         return {};
       }
     };
 
+    message<threadsafe::no> reset
+    {
+      this, "reset", "Scatter a new crowd of numMoshers moshers.",
+      MIN_FUNCTION
+      {
+        if (m_pit)
+        {
+          sync_settings();
+          m_pit->reset();
+        }
+        else init_pit(settings());
+        return {};
+      }
+    };
+
     message<> paint
     {
       this, "paint",
@@ -205,17 +307,235 @@ public:
           line_width{ 1.0 }
         };
 
-        nbl_bin();
-        for (int i {}; i < frameskip; ++i)
+        draw_all(t);
+
+        return {};
+      }
+    };
+
+    message<threadsafe::no> stats
+    {
+      this, "stats", "Report frames, steps/sec, messages sent and the fullest neighbour cell since the last report, and frames dropped by the current or last recording, out the right outlet (plus timings and pairs evaluated when built with MZED_PROFILE).",
+      MIN_FUNCTION
+      {
+        const moshpit_counters& counters{ m_snapshot.counters };
+        const double seconds{ m_statsWindow.restart() };
+        const double steps{ static_cast<double>(counters.steps - m_reported.steps) };
+        const double pairs{ static_cast<double>(counters.pairs - m_reported.pairs) };
+
+        dumpout.send("frames", static_cast<double>(m_frame - m_reportedFrame));
+        dumpout.send("steps", steps);
+        dumpout.send("steps_per_sec", seconds > 0.0 ? steps / seconds : 0.0);
+        dumpout.send("messages_sent", static_cast<double>(m_messages));
+        dumpout.send("recording_dropped", static_cast<double>(m_recorder.dropped()));
+        dumpout.send("max_cell_occupancy", m_occupancy);
+
+        if (mzed::profiling)
         {
-          update();
+          dumpout.send("nbl_bin_ns", since_report(counters.binTime, m_reported.binTime).ns_per_call());
+          dumpout.send("update_ns", since_report(counters.updateTime, m_reported.updateTime).ns_per_call());
+          dumpout.send("draw_ns", m_drawTime.ns_per_call());
+          dumpout.send("pairs", pairs);
+          dumpout.send("pairs_per_step", steps > 0.0 ? pairs / steps : 0.0);
         }
-        draw_all(t);
 
+        m_reportedFrame = m_frame;
+        m_reported = counters;
+        m_occupancy = 0;
+        m_messages = 0;
+        m_drawTime.clear();
+        return {};
+      }
+    };
+
+    message<threadsafe::no> allocations
+    {
+      this, "allocations", "Post the heap allocations counted while simulating and drawing (debug builds with MZED_COUNT_ALLOCATIONS).",
+      MIN_FUNCTION
+      {
+        if (mzed::counting_allocations)
+        {
+          cout << "update: " << m_snapshot.counters.updateAllocations.last << " allocations in the last call, " << m_snapshot.counters.updateAllocations.peak << " at most" << endl;
+          cout << "draw: " << m_drawAllocations.last << " allocations in the last call, " << m_drawAllocations.peak << " at most" << endl;
+        }
+        else cout << "allocation counting is not compiled in, configure with -DMZED_COUNT_ALLOCATIONS=ON" << endl;
+        return {};
+      }
+    };
+
+    message<threadsafe::no> record
+    {
+      this, "record", "Stream every mosher of every drawn frame to a file: record <path> [csv|binary]. No path stops recording.",
+      MIN_FUNCTION
+      {
+        if (!mzed::record_message(m_recorder, args, cout)) cerr << "could not open file for recording" << endl;
         return {};
       }
     };
 
+    message<threadsafe::no> nearest
+    {
+      this, "nearest", "Send the k moshers nearest a point out the right outlet, closest first: nearest <x> <y> <k>, in the coordinates out2 uses.",
+      MIN_FUNCTION
+      {
+        if (args.size() < 3)
+        {
+          cerr << "usage: nearest <x> <y> <k>" << endl;
+          return {};
+        }
+
+        // k is read as a double and capped at the crowd, so a huge or negative one can't wrap
+        const double wanted{ args[2] };
+        const size_t k{ wanted >= 1.0 ? static_cast<size_t>(std::min(wanted, static_cast<double>(m_snapshot.size()))) : 0 };
+        const auto scale{ pit_per_pixel() };
+        m_snapshot.nearest(double(args[0]) * scale[0], double(args[1]) * scale[1], k, m_found);
+        reply("nearest");
+        return {};
+      }
+    };
+
+    message<threadsafe::no> within
+    {
+      this, "within", "Send the moshers within a radius of a point out the right outlet, closest first: within <x> <y> <radius>, in the coordinates out2 uses.",
+      MIN_FUNCTION
+      {
+        if (args.size() < 3)
+        {
+          cerr << "usage: within <x> <y> <radius>" << endl;
+          return {};
+        }
+
+        const auto scale{ pit_per_pixel() };
+        m_found.clear();
+        m_snapshot.within(double(args[0]) * scale[0], double(args[1]) * scale[1], double(args[2]) * std::sqrt(scale[0] * scale[1]), m_found);
+        std::sort(m_found.begin(), m_found.end());
+        reply("within");
+        return {};
+      }
+    };
+
+    message<threadsafe::no> count_in_rect
+    {
+      this, "count_in_rect", "Send how many moshers are inside a rectangle out the right outlet: count_in_rect <left> <top> <right> <bottom>, in the coordinates out2 uses.",
+      MIN_FUNCTION
+      {
+        if (args.size() < 4)
+        {
+          cerr << "usage: count_in_rect <left> <top> <right> <bottom>" << endl;
+          return {};
+        }
+
+        const auto scale{ pit_per_pixel() };
+        const size_t inside{ m_snapshot.count_in_rect(double(args[0]) * scale[0], double(args[1]) * scale[1], double(args[2]) * scale[0], double(args[3]) * scale[1]) };
+        dumpout.send("count_in_rect", static_cast<int>(inside));
+        return {};
+      }
+    };
+
+    message<> field
+    {
+      this, "field", "Add a point that attracts (positive strength) or repels (negative) every mosher within its radius: field <x> <y> <strength> <radius>, in the coordinates out2 uses. Strength is limited to 100 either way.",
+      MIN_FUNCTION
+      {
+        if (args.size() < 4)
+        {
+          cerr << "usage: field <x> <y> <strength> <radius>" << endl;
+          return {};
+        }
+
+        const moshpit_field added{ args[0], args[1], std::clamp(double(args[2]), -MAX_FIELD_STRENGTH, MAX_FIELD_STRENGTH), args[3] };
+        if (!std::isfinite(added.x) || !std::isfinite(added.y) || !std::isfinite(added.strength) || !std::isfinite(added.radius) || added.radius <= 0.0)
+        {
+          cerr << "field needs finite numbers and a radius above 0" << endl;
+          return {};
+        }
+
+        bool full{};
+        m_fields.change([&](view_fields& latest) {
+          full = latest.count == MAX_FIELDS;
+          if (!full) latest.fields[latest.count++] = added;
+        });
+        if (full) cerr << "no more than " << MAX_FIELDS << " fields" << endl;
+        return {};
+      }
+    };
+
+    message<> clearfields
+    {
+      this, "clearfields", "Remove all attracting and repelling fields.",
+      MIN_FUNCTION
+      {
+        m_fields.change([](view_fields& latest) { latest.count = 0; });
+        return {};
+      }
+    };
+
+    message<threadsafe::no> select
+    {
+      this, "select", "Choose the moshers followed by the multichannel outlet, one per voice: select <mosher> [mosher ...]. Other voices follow the mosher with their own number.",
+      MIN_FUNCTION
+      {
+        for (size_t voice{}; voice < MAX_VOICES; ++voice)
+        {
+          m_selection[voice] = voice < args.size() ? std::max(0, int(args[voice])) : static_cast<int>(voice);
+        }
+        return {};
+      }
+    };
+
+    message<> multichanneloutputs
+    {
+      this, "multichanneloutputs",
+      MIN_FUNCTION
+      {
+        return { 3 * voices };
+      }
+    };
+
+    /// Audio: each channel glides to the latest frame over the time until the next is expected,
+    /// so positions move smoothly at audio rate. A coordinate that jumps more than half the pit
+    /// has wrapped around the walls and is cut to, not swept across; so is the very first frame.
+    void operator()(audio_bundle, audio_bundle output)
+    {
+        const size_t channels{ std::min(static_cast<size_t>(output.channel_count()), 3 * MAX_VOICES) };
+
+        if (m_voices.update())
+        {
+            const voice_frame& frame{ m_voices.front() };
+            const double progress{ std::min(1.0, m_rampPosition / m_rampLength) };
+
+            for (size_t channel{}; channel < channels; ++channel)
+            {
+                const double now{ m_from[channel] + (m_to[channel] - m_from[channel]) * progress };
+                const double next{ frame.values[channel] };
+                const bool wrapped{ channel % 3 != 2 && std::fabs(next - now) > 0.5 };
+                m_from[channel] = (wrapped || !m_sounding) ? next : now;
+                m_to[channel] = next;
+            }
+
+            m_rampLength = std::max(1.0, frame.seconds * samplerate());
+            m_rampPosition = 0.0;
+            m_sounding = true;
+        }
+
+        for (size_t channel{}; channel < static_cast<size_t>(output.channel_count()); ++channel)
+        {
+            auto out{ output.samples(channel) };
+
+            for (int i{}; i < output.frame_count(); ++i)
+            {
+                if (channel >= channels) out[i] = 0.0;
+                else
+                {
+                    const double progress{ std::min(1.0, (m_rampPosition + i) / m_rampLength) };
+                    out[i] = m_from[channel] + (m_to[channel] - m_from[channel]) * progress;
+                }
+            }
+        }
+
+        m_rampPosition += output.frame_count();
+    }
+
     message<> maxclass_setup
     {
       this, "maxclass_setup",
@@ -231,268 +551,251 @@ public:
 
 private:
 
-    double r[ARRAY_SIZE]{};
-    double mpX[ARRAY_SIZE]{};
-    double mpY[ARRAY_SIZE]{};
-    size_t type[ARRAY_SIZE]{};
-    double vx[ARRAY_SIZE]{};
-    double vy[ARRAY_SIZE]{};
-    double fx[ARRAY_SIZE]{};
-    double fy[ARRAY_SIZE]{};
-    double col[ARRAY_SIZE]{};
-
-    //neighbor list
-    int lx{};
-    int ly{};
-    int m_size[2]{ 0, 0 };
-    std::vector<int> cells{};
-    std::array<int, ARRAY_SIZE> count{};
-
-    //things we can change
-    int pbc[2]{ 1, 1 };
-    int epsilon{ 100 };
-
-    const color greyColor{ 0.5, 0.5, 0.5, 0.8 };
-    const color redColor{ 1.0, 0.3, 0.0, 0.8 }; //really orange
-    const color yellowColor{ 1.0, 1.0, 0., 0.8 };
+    // a crowd of our own, or a pit shared with the other views of the same name; either way
+    // drawing, queries and the multichannel outlet read the latest snapshot of it
+    moshpit_crowd m_crowd{};
+    std::shared_ptr<shared_pit> m_pit{};
+    moshpit_settings m_applied{};   // what the crowd was last scattered and stepped with
+    bool m_listening{};
+    moshpit_snapshot m_snapshot{};
+
+    const c74::max::t_jrgba greyColor{ 0.5, 0.5, 0.5, 0.8 };
+    const c74::max::t_jrgba redColor{ 1.0, 0.3, 0.0, 0.8 }; //really orange
+    const c74::max::t_jrgba yellowColor{ 1.0, 1.0, 0., 0.8 };
+
+    // reused for every send and counted in debug builds, so the per-mosher loops don't allocate
+    atoms m_out1{ 0.0, 0.0, 0.0 };
+    atoms m_out2{ 0, 0, 0.0, 0.0, 0.0 };
+    mzed::allocation_counter m_drawAllocations{};
+
+    // stats since the last report
+    moshpit_counters m_reported{};
+    int m_occupancy{};
+    mzed::section_timer m_drawTime{};
+    mzed::stats_window m_statsWindow{};
+    uint64_t m_reportedFrame{};
+    uint64_t m_messages{};
+
+    // multichannel outlet: written by the simulation, read by the audio thread
+    std::array<int, MAX_VOICES> m_selection{};
+    mzed::triple_buffer<voice_frame> m_voices{};
+    std::array<double, 3 * MAX_VOICES> m_from{};
+    std::array<double, 3 * MAX_VOICES> m_to{};
+    double m_rampLength{ 1.0 };
+    double m_rampPosition{};
+    bool m_sounding{};
+
+    // spatial queries and fields, in the units of the last view drawn
+    std::array<double, 2> m_view{ 200.0, 200.0 };
+    std::vector<std::pair<double, int>> m_found{};
+    atoms m_reply{};
+    mzed::parameter_block<view_fields> m_fields{ view_fields{} };
+    view_fields m_pitFields{};      // the fields of the frame being stepped, in the pit's units
+
+    uint64_t m_frame{};
+    mzed::recorder<6> m_recorder{ { "frame", "mosher", "type", "x", "y", "force" } };
 
     //////////////////////////////////////////////////////////////    functions
 
-    int moshpit_mod_rvec(const int a, const int b, const int p, int* image)
+    void init_pit(const moshpit_settings& with)
     {
-        *image = 1;
+        m_crowd.init(with.count, with.fractionRed, with.precision);
+        m_crowd.snapshot(m_snapshot);
+        m_applied = with;
+    }
 
-        if (b == 0 && a == 0)
+    /// The attributes a shared pit takes from its views.
+    moshpit_settings settings() const
+    {
+        return { { noise, flock, m_pitFields.fields, m_pitFields.count }, frameskip, framerate, precision, numMoshers, fractionRed };
+    }
+
+    /// Join the pit called pit_name, or scatter a pit of our own if it's empty. A view joining
+    /// a running pit leaves it as it is until one of its own attributes changes.
+    void attach(const symbol& pit_name)
+    {
+        const bool listening{ m_listening };
+        const std::string key{ pit_name.c_str() };
+
+        listen(false);
+        m_pit.reset();
+
+        if (key.empty()) init_pit(settings());
+        else
         {
-            *image = 0;
-            return 0;
+            m_pit = shared_pit::attach(key, settings());
+            m_snapshot.version = 0;
+            m_pit->read(m_snapshot);
+            m_applied = settings();
         }
 
-        if (p != 0)
+        m_reported = m_snapshot.counters;
+        listen(listening);
+        arrived();
+    }
+
+    /// Let a shared pit know when this view is on, so it only runs while someone's watching.
+    void listen(const bool listening)
+    {
+        if (m_pit && listening != m_listening)
         {
-            if (a > b) return a - b - 1;
-            if (a < 0) return a + b + 1;
+            if (listening) m_pit->listen();
+            else m_pit->unlisten();
         }
-        else
+        m_listening = listening;
+    }
+
+    /// Pass the attributes changed on this view, and only those, to the shared pit.
+    void sync_settings()
+    {
+        const moshpit_settings wanted{ settings() };
+        if (wanted != m_applied)
         {
-            if (a > b) return b;
-            if (a < 0) return 0;
+            m_pit->configure(m_applied, wanted);
+            m_applied = wanted;
         }
-
-        *image = 0;
-        return a;
     }
 
-    void nbl_bin()
+    /// Convert the newest fields to the pit's units for the frame about to be stepped.
+    void take_fields()
     {
-        count.fill(0);
+        const view_fields& latest{ m_fields.acquire() };
+        const auto scale{ pit_per_pixel() };
 
-        for (int mosher{}; mosher < numMoshers; ++mosher)
+        m_pitFields.count = latest.count;
+        for (size_t f{}; f < latest.count; ++f)
         {
-            const size_t indX{ static_cast<size_t>(mpX[mosher] / lx * m_size[0]) };
-            const size_t indY{ static_cast<size_t>(mpY[mosher] / ly * m_size[1]) };
-            const size_t tt{ indX + indY * m_size[0] };
-            cells[NMAX * tt + count[tt]] = mosher;
-            ++count[tt];
+            const moshpit_field& field{ latest.fields[f] };
+            m_pitFields.fields[f] = { field.x * scale[0], field.y * scale[1], field.strength, field.radius * std::sqrt(scale[0] * scale[1]) };
         }
     }
 
-    inline double normRand()
+    void arrived()
+    {
+        m_occupancy = std::max(m_occupancy, m_snapshot.occupancy);
+        publish_voices();
+    }
+
+    static mzed::section_timer since_report(const mzed::section_timer& now, const mzed::section_timer& reported)
     {
-        return (double)rand() / (double)RAND_MAX;
+        return { now.calls - reported.calls, now.nanoseconds - reported.nanoseconds };
     }
 
-    inline double mymod(const double a, const double b)
-    { //TODO: MZ why?
-        return a - b * floor(a / b) + b * (a < 0);
+    /// Simulation units per pixel of the last view drawn, so queries can use out2's coordinates.
+    std::array<double, 2> pit_per_pixel() const
+    {
+        return { m_snapshot.side / m_view[0], m_snapshot.side / m_view[1] };
     }
 
-    void update()
+    /// Send the moshers found by a query out the dumpout, after the query's name.
+    void reply(const char* query)
     {
-        int image[2]{ 0, 0 };
+        m_reply.clear();
+        m_reply.push_back(symbol(query));
+        for (const auto& [distance, mosher] : m_found) m_reply.push_back(mosher);
+        dumpout.send(m_reply);
+    }
 
-        for (size_t mosher{}; mosher < numMoshers; ++mosher)
-        {
-            col[mosher] = 0.0;
-            fx[mosher] = 0.0;
-            fy[mosher] = 0.0;
+    static double force_level(const double force)
+    {
+        return std::clamp(std::fabs(force / 25), 0.0, 1.0);
+    }
 
-            double wx{};
-            double wy{};
-            long neigh{};
+    void publish_voices()
+    {
+        voice_frame& frame{ m_voices.back() };
+        const double side{ static_cast<double>(m_snapshot.side) };
 
-            const int indX{ static_cast<int>(mpX[mosher] / lx * m_size[0]) };
-            const int indY{ static_cast<int>(mpY[mosher] / ly * m_size[1]) };
+        for (size_t voice{}; voice < MAX_VOICES; ++voice)
+        {
+            const size_t mosher{ static_cast<size_t>(m_selection[voice]) };
+            const bool present{ mosher < m_snapshot.size() };
+            frame.values[3 * voice] = present ? m_snapshot.x[mosher] / side : 0.0;
+            frame.values[3 * voice + 1] = present ? m_snapshot.y[mosher] / side : 0.0;
+            frame.values[3 * voice + 2] = present ? force_level(m_snapshot.force[mosher]) : 0.0;
+        }
 
-            for (int ttx{ -1 }; ttx <= 1; ++ttx)
-            {
-                for (int tty{ -1 }; tty <= 1; ++tty)
-                {
-                    bool goodcell{ true };
-                    const int tixx{ moshpit_mod_rvec(indX + ttx, m_size[0] - 1, pbc[0], &image[0]) };
-                    const int tixy{ moshpit_mod_rvec(indY + tty, m_size[1] - 1, pbc[1], &image[1]) };
-
-                    if ((pbc[0] < image[0]) || (pbc[1] < image[1])) goodcell = 0;
-
-                    if (goodcell)
-                    {
-                        long cell{ tixx + (tixy * m_size[0]) };
-
-                        for (int cc{}; cc < count[cell]; ++cc)
-                        {
-                            long j{ cells[NMAX * cell + cc] };
-                            double dx{ mpX[j] - mpX[mosher] };
-                            if (image[0]) dx += lx * ttx;
-
-                            double dy{ mpY[j] - mpY[mosher] };
-                            if (image[1]) dy += ly * tty;
-
-                            double l{ sqrt(dx * dx + dy * dy) };
-                            if (l > 1e-6 && l < TWO_R)
-                            {
-                                double r0{ r[mosher] + r[j] };
-                                double f{ (1 - l / r0) };
-                                double c0{ -(epsilon)*f * f * (l < r0) };
-
-                                fx[mosher] += c0 * dx;
-                                fy[mosher] += c0 * dy;
-                                col[mosher] += c0 * c0 * dx * dx + c0 * c0 * dy * dy; //fx[i]*fx[i] + fy[i]*fy[i]
-                            }
-
-                            if (type[mosher] > 0 && type[j] > 0 && l > 1e-6 && l < FR)
-                            {
-                                wx += vx[j];
-                                wy += vy[j];
-                                ++neigh;
-                            }
-                        }
-                    }
-                }
-            }
+        frame.seconds = 1.0 / std::max(1, m_applied.fps);
+        m_voices.publish();
+    }
 
-            const double wlen{ (wx * wx + wy * wy) };
+    /// Send every mosher out out2 (and its position and force out out1), in the pixels of the
+    /// last view drawn, and record them.
+    void send_frame()
+    {
+        const moshpit_snapshot& sim{ m_snapshot };
+        const double sx{ m_view[0] / sim.side };
+        const double sy{ m_view[1] / sim.side };
 
-            if (type[mosher] > 0 && neigh > 0 && wlen > 1e-6)
-            {
-                fx[mosher] += flock * wx / wlen;
-                fy[mosher] += flock * wy / wlen;
-            }
+        for (size_t mosher{}; mosher < sim.size(); ++mosher)
+        {
+            const double x{ sx * sim.x[mosher] };
+            const double y{ sy * sim.y[mosher] };
+            const int type{ sim.type[mosher] };
+            const double force{ force_level(sim.force[mosher]) * 100 };
+
+            m_out2[0] = static_cast<int>(mosher);
+            m_out2[1] = type;
+            m_out2[2] = x;
+            m_out2[3] = y;
+            m_out2[4] = force;
+            out2.send(m_out2);
+
+            m_out1[0] = x;
+            m_out1[1] = y;
+            m_out1[2] = force;
+            out1.send(m_out1);
+            m_recorder.push(m_frame, mosher, type, x, y, force);
+        }
+        ++m_frame;
+        m_messages += 2 * static_cast<uint64_t>(sim.size());
+    }
 
-            const double vlen{ vx[mosher] * vx[mosher] + vy[mosher] * vy[mosher] };
-            const double vhap{ type[mosher] > 0 ? VHAPPY : 0.0 };
+    void draw_all(target t)
+    {
+        const moshpit_snapshot& sim{ m_snapshot };
+        mzed::allocation_scope scope{ m_drawAllocations };
+        mzed::profile_scope timing{ m_drawTime };
+        c74::max::t_jgraphics* g{ t };
 
-            if (vlen > 1e-6)
-            {
-                fx[mosher] += DAMP * (vhap - vlen) * vx[mosher] / vlen;
-                fy[mosher] += DAMP * (vhap - vlen) * vy[mosher] / vlen;
-            }
+        m_view = { t.width(), t.height() };
+        if (!drawing) return;
 
-            if (type[mosher] > 0)
-            {
-                fx[mosher] += noise * (normRand() - 0.5);
-                fy[mosher] += noise * (normRand() - 0.5);
-            }
-        }
+        const double sx{ t.width() / sim.side };
+        const double sy{ t.height() / sim.side };
+        const double ss{ sqrt(sx * sy) * 2.0 };
 
-        for (size_t mosher{}; mosher < numMoshers; ++mosher)
+        for (size_t mosher{}; mosher < sim.size(); ++mosher)
         {
-            vx[mosher] += fx[mosher] * GDT;
-            vy[mosher] += fy[mosher] * GDT;
-            mpX[mosher] += vx[mosher] * GDT;
-            mpY[mosher] += vy[mosher] * GDT;
-
-            if (pbc[0] == 0)
+            const double x{ sim.x[mosher] };
+            const double y{ sim.y[mosher] };
+            const double r{ sim.radius[mosher] };
+            const int type{ sim.type[mosher] };
+            const double cr{ force_level(sim.force[mosher]) };
+            c74::max::t_jrgba mosherColor;
+
+            if (type == 0)
             {
-                if (mpX[mosher] >= lx)
-                {
-                    mpX[mosher] = 2 * lx - mpX[mosher];
-                    vx[mosher] *= -1;
-                }
-                if (mpX[mosher] < 0)
-                {
-                    mpX[mosher] = -(mpX[mosher]);
-                    vx[mosher] *= -1;
-                }
-            }
-            else
-            {
-                if (mpX[mosher] >= lx || mpX[mosher] < 0) mpX[mosher] = mymod(mpX[mosher], lx);
+                if (showForce == true) mosherColor = { cr, cr, cr, 0.8 };
+                else mosherColor = greyColor;
             }
-
-            if (pbc[1] == 0)
+            else if (type == 2) // yellow
             {
-                if (mpY[mosher] >= ly)
-                {
-                    mpY[mosher] = 2 * ly - mpY[mosher];
-                    vy[mosher] *= -1;
-                }
-                if (mpY[mosher] < 0)
-                {
-                    mpY[mosher] = -(mpY[mosher]);
-                    vy[mosher] *= -1;
-                }
+                if (showForce == true) mosherColor = { 1.0, 1.0, 0.0, cr };
+                else mosherColor = yellowColor;
             }
             else
             {
-                if (mpY[mosher] >= ly || mpY[mosher] < 0) mpY[mosher] = mymod(mpY[mosher], ly);
+                if (showForce == true) mosherColor = { 1.0, 0.0, 0.0, cr };
+                else mosherColor = redColor;
             }
-            /*
-             TODO: Do I need this?
-             if (dovorticity == true)
-             {
-              graph_vel(sqrt(x->vx[i]*x->vx[i] + x->vy[i]* x->vy[i]));
-             }*/
-        }
-    }
-
-    void draw_all(target t)
-    {
-        const double sx{ t.width() / lx };
-        const double sy{ t.height() / ly };
-        const double ss{ sqrt(sx * sy) * 2.0 };
 
-        for (size_t mosher{}; mosher < numMoshers; ++mosher)
-        {
-            const double cr{ std::clamp(fabs(col[mosher] / 25), 0.0, 1.0) };
-
-            if (drawing)
-            {
-                color mosherColor;
-
-                if (type[mosher] == 0)
-                {
-                    if (showForce == true) mosherColor = { cr, cr, cr, 0.8 };
-                    else mosherColor = greyColor;
-                }
-                else if (type[mosher] == 2) // yellow
-                {
-                    if (showForce == true) mosherColor = { 1.0, 1.0, 0.0, cr };
-                    else mosherColor = yellowColor;
-                }
-                else
-                {
-                    if (showForce == true) mosherColor = { 1.0, 0.0, 0.0, cr };
-                    else mosherColor = redColor;
-                }
-
-                const double shim{ ss * r[mosher] * 0.5 };
-
-                ellipse<fill> mosherEllipse
-                {
-                  t,
-                  color{ mosherColor },
-                  position{ sx * mpX[mosher] - shim, sy * mpY[mosher] - shim },
-   
-                  size{ ss * r[mosher], ss * r[mosher] }
-                };
-            }
+            const double shim{ ss * r * 0.5 };
 
-            out2.send(static_cast<int>(mosher), 
-                      static_cast<int>(type[mosher]), 
-                      sx * mpX[mosher], 
-                      sy * mpY[mosher], 
-                      cr * 100);
-            out1.send(sx * mpX[mosher], sy * mpY[mosher], cr * 100);
+            // straight to jgraphics: building an ellipse<> per mosher is too heavy for this loop
+            c74::max::jgraphics_set_source_jrgba(g, &mosherColor);
+            c74::max::jgraphics_ellipse(g, sx * x - shim, sy * y - shim, ss * r, ss * r);
+            c74::max::jgraphics_fill(g);
         }
     }
 };
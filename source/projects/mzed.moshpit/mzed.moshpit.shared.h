@@ -0,0 +1,240 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "mzed.moshpit.sim.h"
+#include "mzed.parameters.h"
+#include "mzed.precision.h"
+#include "mzed.triplebuffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// Everything about a pit that its views share, as opposed to how each one draws it.
+struct moshpit_settings
+{
+    moshpit_params params{};
+    int frameskip{ 2 };
+    int fps{ 30 };
+    mzed::precisions precision{ mzed::precisions::double_precision };
+    int count{ 300 };
+    double fractionRed{ 0.15 };
+};
+
+/// Whether two sets of params hold the same fields.
+inline bool same_fields(const moshpit_params& a, const moshpit_params& b)
+{
+    if (a.fieldCount != b.fieldCount) return false;
+
+    for (size_t f{}; f < a.fieldCount; ++f)
+    {
+        const moshpit_field& p{ a.fields[f] };
+        const moshpit_field& q{ b.fields[f] };
+        if (p.x != q.x || p.y != q.y || p.strength != q.strength || p.radius != q.radius) return false;
+    }
+    return true;
+}
+
+inline bool operator==(const moshpit_settings& a, const moshpit_settings& b)
+{
+    if (a.params.noise != b.params.noise || a.params.flock != b.params.flock || !same_fields(a.params, b.params)) return false;
+
+    return a.frameskip == b.frameskip && a.fps == b.fps && a.precision == b.precision && a.count == b.count && a.fractionRed == b.fractionRed;
+}
+
+inline bool operator!=(const moshpit_settings& a, const moshpit_settings& b)
+{
+    return !(a == b);
+}
+
+/// Copy into latest each setting that differs between from and to, leaving the rest as they are.
+inline void merge_changes(const moshpit_settings& from, const moshpit_settings& to, moshpit_settings& latest)
+{
+    if (to.params.noise != from.params.noise) latest.params.noise = to.params.noise;
+    if (to.params.flock != from.params.flock) latest.params.flock = to.params.flock;
+    if (!same_fields(to.params, from.params))
+    {
+        latest.params.fields = to.params.fields;
+        latest.params.fieldCount = to.params.fieldCount;
+    }
+    if (to.frameskip != from.frameskip) latest.frameskip = to.frameskip;
+    if (to.fps != from.fps) latest.fps = to.fps;
+    if (to.precision != from.precision) latest.precision = to.precision;
+    if (to.count != from.count) latest.count = to.count;
+    if (to.fractionRed != from.fractionRed) latest.fractionRed = to.fractionRed;
+}
+
+/// Whether going from one set of settings to the other needs a new crowd.
+inline bool rescatters(const moshpit_settings& from, const moshpit_settings& to)
+{
+    return from.count != to.count || from.fractionRed != to.fractionRed;
+}
+
+/// One crowd watched by every mzed.moshpit with the same name. An owner thread steps it at the
+/// shared frame rate while at least one view is on, and hands each frame to the views as a
+/// snapshot, so the simulation runs once however many views there are. The pit lives as long
+/// as a view holds it.
+class shared_pit
+{
+public:
+    explicit shared_pit(const moshpit_settings& settings) : m_settings{ settings }
+    {
+        m_crowd.init(settings.count, settings.fractionRed, settings.precision);
+        m_crowd.snapshot(m_snapshots.back());
+        m_snapshots.back().version = ++m_published;
+        m_snapshots.publish();
+        m_owner = std::thread{ [this] { run(); } };
+    }
+
+    ~shared_pit()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_owner.join();
+    }
+
+    shared_pit(const shared_pit&) = delete;
+    shared_pit& operator=(const shared_pit&) = delete;
+
+    /// The pit called name, made with settings if no view holds one yet.
+    static std::shared_ptr<shared_pit> attach(const std::string& name, const moshpit_settings& settings)
+    {
+        static std::mutex registry_mutex{};
+        static std::map<std::string, std::weak_ptr<shared_pit>> registry{};
+
+        std::lock_guard<std::mutex> lock{ registry_mutex };
+
+        for (auto entry{ registry.begin() }; entry != registry.end();)
+        {
+            if (entry->second.expired()) entry = registry.erase(entry);
+            else ++entry;
+        }
+
+        std::shared_ptr<shared_pit> pit{ registry[name].lock() };
+        if (!pit)
+        {
+            pit = std::make_shared<shared_pit>(settings);
+            registry[name] = pit;
+        }
+        return pit;
+    }
+
+    /// Change how the crowd is stepped from the next frame on, taking only the settings a view
+    /// changed from its last ones to its new ones, so it doesn't undo what other views have
+    /// changed since. Scatters a new crowd first if its size or proportion of active moshers
+    /// changes.
+    void configure(const moshpit_settings& from, const moshpit_settings& to)
+    {
+        bool scatter{};
+        m_settings.change([&](moshpit_settings& latest) {
+            const moshpit_settings before{ latest };
+            merge_changes(from, to, latest);
+            scatter = rescatters(before, latest);
+        });
+        if (scatter) reset();
+    }
+
+    /// Scatter a new crowd before the next frame, using the latest settings.
+    void reset()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            ++m_generation;
+        }
+        m_wake.notify_all();
+    }
+
+    /// A view has been turned on; the pit runs while any are.
+    void listen()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            ++m_listeners;
+        }
+        m_wake.notify_all();
+    }
+
+    void unlisten()
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        --m_listeners;
+    }
+
+    /// Copy the newest frame into out unless out already holds it. Returns whether it changed.
+    bool read(moshpit_snapshot& out)
+    {
+        std::lock_guard<std::mutex> lock{ m_readers };
+        m_snapshots.update();
+
+        const moshpit_snapshot& newest{ m_snapshots.front() };
+        if (newest.version == out.version) return false;
+        out = newest;
+        return true;
+    }
+
+private:
+    moshpit_crowd m_crowd{};
+    mzed::triple_buffer<moshpit_snapshot> m_snapshots{};
+    uint64_t m_published{};
+    std::mutex m_readers{};     // the views share the reading end of m_snapshots
+
+    // handed to the owner thread once per frame
+    mzed::parameter_block<moshpit_settings> m_settings;
+
+    // guarded by m_mutex
+    std::mutex m_mutex{};
+    std::condition_variable m_wake{};
+    uint64_t m_generation{};
+    int m_listeners{};
+    bool m_stopping{};
+
+    std::thread m_owner{};
+
+    void run()
+    {
+        uint64_t generation{};
+        auto next{ std::chrono::steady_clock::now() };
+
+        for (;;)
+        {
+            bool scatter{};
+            {
+                std::unique_lock<std::mutex> lock{ m_mutex };
+                const bool paused{ m_listeners == 0 };
+                m_wake.wait(lock, [&] { return m_stopping || m_listeners > 0 || m_generation != generation; });
+                if (m_stopping) return;
+
+                scatter = m_generation != generation;
+                generation = m_generation;
+                if (paused) next = std::chrono::steady_clock::now();
+            }
+
+            const moshpit_settings& settings{ m_settings.acquire() };
+            if (scatter) m_crowd.init(settings.count, settings.fractionRed, settings.precision);
+            else m_crowd.step(settings.params, settings.frameskip, settings.precision);
+
+            moshpit_snapshot& frame{ m_snapshots.back() };
+            m_crowd.snapshot(frame);
+            frame.version = ++m_published;
+            m_snapshots.publish();
+
+            if (scatter) continue;
+
+            // keep to the frame rate, but don't race to catch up after falling behind
+            next = std::max(next + std::chrono::microseconds{ 1000000 / std::max(1, settings.fps) }, std::chrono::steady_clock::now());
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_wake.wait_until(lock, next, [this] { return m_stopping; });
+        }
+    }
+};
@@ -0,0 +1,695 @@
+/// @file
+///	@ingroup 	mzed
+///	@copyright	Copyright 2016-2025 Michael Zbyszyński  All rights reserved.
+///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
+
+#pragma once
+
+#include "mzed.allocations.h"
+#include "mzed.precision.h"
+#include "mzed.profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+constexpr double RADIUS{ 1.0 };
+constexpr size_t TWO_R{ 2 };
+constexpr size_t FR{ 2 };
+constexpr double VHAPPY{ 1.0 };
+constexpr double DAMP{ 1.0 };
+constexpr double GDT{ 0.1 };
+constexpr size_t MAX_FIELDS{ 16 };
+constexpr double MAX_FIELD_STRENGTH{ 100.0 };   // the most force a field exerts, at its centre
+
+/// A point that pulls moshers towards it (positive strength) or pushes them away (negative),
+/// with a force that fades linearly to nothing at radius. In simulation units.
+struct moshpit_field
+{
+    double x{};
+    double y{};
+    double strength{};
+    double radius{};
+};
+
+/// Settings that may change between steps.
+struct moshpit_params
+{
+    double noise{ 3.0 };
+    double flock{ 1.0 };
+    std::array<moshpit_field, MAX_FIELDS> fields{};
+    size_t fieldCount{};
+};
+
+/// What the simulation reports to the object's stats and allocations messages.
+struct moshpit_counters
+{
+    mzed::section_timer binTime{};
+    mzed::section_timer updateTime{};
+    mzed::allocation_counter updateAllocations{};
+    uint64_t steps{};
+    uint64_t pairs{};
+};
+
+/// Shortest offset between two coordinates, going across the wall when it wraps.
+inline double moshpit_separation(const double delta, const int length, const int periodic)
+{
+    if (periodic == 0) return delta;
+    if (delta > length * 0.5) return delta - length;
+    if (delta < -length * 0.5) return delta + length;
+    return delta;
+}
+
+/// A copy of the crowd as of one drawing frame: everything a view needs to draw it, feed the
+/// multichannel outlet and answer spatial queries without touching the running simulation.
+/// The neighbour grid is stored compactly: the moshers in cell c are order[cellStart[c]]
+/// up to, but not including, order[cellStart[c + 1]].
+struct moshpit_snapshot
+{
+    int side{};
+    int columns{ 1 };
+    int rows{ 1 };
+    int periodic[2]{ 1, 1 };
+    std::vector<double> x{};
+    std::vector<double> y{};
+    std::vector<double> radius{};
+    std::vector<double> force{};
+    std::vector<int> type{};
+    std::vector<int> cellStart{ 0, 0 };
+    std::vector<int> order{};
+    int occupancy{};              ///< moshers in the fullest cell
+    moshpit_counters counters{};  ///< totals since the crowd was created
+    uint64_t version{};
+
+    size_t size() const { return x.size(); }
+
+    /// Append (distance², mosher) for every mosher within radius of (cx, cy) to found, measuring
+    /// across the walls where they wrap. Only the grid cells the circle touches are visited.
+    /// Nothing is found around a point or radius that isn't a finite number.
+    void within(double cx, double cy, const double radius, std::vector<std::pair<double, int>>& found) const
+    {
+        if (size() == 0 || !std::isfinite(cx) || !std::isfinite(cy) || !(radius >= 0.0) || !std::isfinite(radius)) return;
+
+        // a point beyond a wrapping wall is the same as its image inside the pit
+        if (periodic[0] != 0) cx -= side * std::floor(cx / side);
+        if (periodic[1] != 0) cy -= side * std::floor(cy / side);
+
+        const auto across{ cell_span(cx, radius, columns, periodic[0]) };
+        const auto down{ cell_span(cy, radius, rows, periodic[1]) };
+
+        for (int row{ down.first }; row <= down.second; ++row)
+        {
+            for (int column{ across.first }; column <= across.second; ++column)
+            {
+                const int cell{ wrap_cell(column, columns) + wrap_cell(row, rows) * columns };
+
+                for (int i{ cellStart[cell] }; i < cellStart[cell + 1]; ++i)
+                {
+                    const int j{ order[i] };
+                    const double dx{ moshpit_separation(x[j] - cx, side, periodic[0]) };
+                    const double dy{ moshpit_separation(y[j] - cy, side, periodic[1]) };
+                    const double d2{ dx * dx + dy * dy };
+                    if (d2 <= radius * radius) found.emplace_back(d2, j);
+                }
+            }
+        }
+    }
+
+    /// Replace found with (distance², mosher) for the k moshers nearest (cx, cy), closest first.
+    /// The search circle starts one cell wide and doubles until it holds k moshers, or until it
+    /// reaches the farthest corner of the pit, so a mosher that can't be measured (e.g. at NaN)
+    /// doesn't keep it going forever.
+    void nearest(const double cx, const double cy, const size_t k, std::vector<std::pair<double, int>>& found) const
+    {
+        found.clear();
+        if (k == 0 || size() == 0 || !std::isfinite(cx) || !std::isfinite(cy)) return;
+
+        const double reach{ std::hypot(cx - side * 0.5, cy - side * 0.5) + side * std::sqrt(0.5) };
+        for (double radius{ static_cast<double>(side) / columns };; radius *= 2)
+        {
+            found.clear();
+            within(cx, cy, radius, found);
+            if (found.size() >= std::min(k, size()) || radius >= reach) break;
+        }
+
+        const size_t keep{ std::min(k, found.size()) };
+        std::partial_sort(found.begin(), found.begin() + keep, found.end());
+        found.resize(keep);
+    }
+
+    /// How many moshers are inside the rectangle, which doesn't wrap around the walls. A
+    /// rectangle with an edge that isn't a finite number holds none.
+    size_t count_in_rect(const double left, const double top, const double right, const double bottom) const
+    {
+        if (size() == 0 || !std::isfinite(left) || !std::isfinite(top) || !std::isfinite(right) || !std::isfinite(bottom)) return 0;
+
+        const int first_column{ clamp_cell(left, columns) };
+        const int last_column{ clamp_cell(right, columns) };
+        const int first_row{ clamp_cell(top, rows) };
+        const int last_row{ clamp_cell(bottom, rows) };
+        size_t inside{};
+
+        for (int row{ first_row }; row <= last_row; ++row)
+        {
+            for (int column{ first_column }; column <= last_column; ++column)
+            {
+                const int cell{ column + row * columns };
+
+                for (int i{ cellStart[cell] }; i < cellStart[cell + 1]; ++i)
+                {
+                    const int j{ order[i] };
+                    if (x[j] >= left && x[j] <= right && y[j] >= top && y[j] <= bottom) ++inside;
+                }
+            }
+        }
+        return inside;
+    }
+
+private:
+    /// The unwrapped range of cells along one axis that a circle around centre touches. The
+    /// ends are worked out in double and only cast once they are known to fit in an int: on a
+    /// wrapping axis centre is inside the pit and the span is narrower than it.
+    std::pair<int, int> cell_span(const double centre, const double radius, const int cells, const int wraps) const
+    {
+        const double first{ std::floor((centre - radius) / side * cells) };
+        const double last{ std::floor((centre + radius) / side * cells) };
+
+        if (last - first + 1 >= cells) return { 0, cells - 1 };
+        if (wraps == 0) return { clamp_cell(centre - radius, cells), clamp_cell(centre + radius, cells) };
+        return { static_cast<int>(first), static_cast<int>(last) };
+    }
+
+    /// The cell along one axis holding a coordinate, with coordinates outside the pit clamped to
+    /// the cells at its edge.
+    int clamp_cell(const double coordinate, const int cells) const
+    {
+        return static_cast<int>(std::clamp(std::floor(coordinate / side * cells), 0.0, cells - 1.0));
+    }
+
+    static int wrap_cell(const int index, const int cells)
+    {
+        return ((index % cells) + cells) % cells;
+    }
+};
+
+/// The particle model behind mzed.moshpit, computed in REAL (float or double).
+/// In float everything is single precision: positions are bounded by the walls of the pit and
+/// forces are summed over a handful of neighbours, so nothing accumulates long enough to drift.
+template <typename REAL>
+class moshpit_sim
+{
+public:
+    /// Scatter a new crowd of moshers, with a circle of active ones in the middle.
+    /// The pit is packed denser than discs can tile (0.94 of its area or more, against 0.91
+    /// for a hexagonal packing), so the crowd starts on a jittered hexagonal lattice that spreads
+    /// the unavoidable overlap evenly. Scattering them at random piles some discs almost on
+    /// top of each other, and the repulsion between those takes many frames to settle.
+    void init(const size_t moshers, const double fractionRed)
+    {
+        m_count = moshers;
+
+        // calculate sidelength
+        lx = 1.03 * sqrt(M_PI * RADIUS * RADIUS * m_count);
+        ly = lx;
+
+        //neighborlist
+        m_size[0] = std::max(1, static_cast<int>(lx / FR));
+        m_size[1] = std::max(1, static_cast<int>(ly / FR));
+
+        count.assign(m_size[0] * m_size[1], 0);
+        cellStart.assign(m_size[0] * m_size[1] + 1, 0);
+        binned.assign(m_count, 0);
+        home.assign(m_count, 0);
+
+        r.assign(m_count, static_cast<REAL>(RADIUS));
+        mpX.resize(m_count);
+        mpY.resize(m_count);
+        type.assign(m_count, 0);
+        vx.resize(m_count);
+        vy.resize(m_count);
+        fx.assign(m_count, 0);
+        fy.assign(m_count, 0);
+        col.assign(m_count, 0);
+
+        // an even number of rows, so alternate rows still interleave across the wrapping wall;
+        // of the counts near a regular hexagonal lattice, the one leaving the widest spacing
+        size_t rows{ 2 };
+        double spacing{};
+        const size_t ideal{ static_cast<size_t>(std::sqrt(m_count / (2 * std::sqrt(3.0)))) };
+        for (size_t half{ ideal > 2 ? ideal - 2 : 1 }; half <= ideal + 2; ++half)
+        {
+            const size_t across{ (m_count + 2 * half - 1) / (2 * half) };
+            const double width{ static_cast<double>(lx) / across };
+            const double height{ static_cast<double>(ly) / (2 * half) };
+            const double nearest{ std::min(width, std::sqrt(width * width / 4 + height * height)) };
+            if (nearest > spacing)
+            {
+                rows = 2 * half;
+                spacing = nearest;
+            }
+        }
+        const size_t columns{ (m_count + rows - 1) / rows };
+        const size_t sites{ rows * columns };
+        const double dx{ static_cast<double>(lx) / columns };
+        const double dy{ static_cast<double>(ly) / rows };
+        const double jitter{ 0.05 * std::min(dx, dy) };
+
+        // leave the spare sites evenly spread, and deal the rest out in random order so mosher
+        // numbers aren't laid out across the pit
+        std::vector<size_t> site(m_count);
+        for (size_t mosher{}; mosher < m_count; ++mosher) site[mosher] = mosher * sites / m_count;
+        for (size_t mosher{ m_count }; mosher > 1; --mosher) std::swap(site[mosher - 1], site[rand() % mosher]);
+
+        // init_circle(x);
+        bool uniq{ true };
+
+        for (size_t mosher{}; mosher < m_count; ++mosher)
+        {
+            const size_t row{ site[mosher] / columns };
+            const size_t column{ site[mosher] % columns };
+            const double tx{ std::fmod((column + 0.5 * (1 + row % 2)) * dx + jitter * (2 * normRand() - 1), lx) };
+            const double ty{ std::fmod((row + 0.5) * dy + jitter * (2 * normRand() - 1), ly) };
+
+            mpX[mosher] = mymod(static_cast<REAL>(tx), static_cast<REAL>(lx));
+            mpY[mosher] = mymod(static_cast<REAL>(ty), static_cast<REAL>(ly));
+
+            const double dd{ sqrt((tx - lx / 2) * (tx - lx / 2) + (ty - ly / 2) * (ty - ly / 2)) };
+            const double rad{ sqrt(fractionRed * lx * ly / M_PI) };
+            const bool doCircle{ true };
+
+            if (doCircle) // Expose this as an attribute?
+            {
+                if (dd < rad)
+                {
+                    type[mosher] = (uniq) ? 2 : 1;
+                    uniq = false;
+                }
+            }
+            else
+            {
+                if (normRand() < fractionRed) type[mosher] = 1;
+            }
+
+            vx[mosher] = static_cast<REAL>(VHAPPY * (normRand() - 0.5));
+            vy[mosher] = static_cast<REAL>(VHAPPY * (normRand() - 0.5));
+        }
+
+        moshpit_counters placement{};
+        nbl_bin(placement);
+    }
+
+    /// Take over the crowd of a simulation running in the other precision.
+    template <typename OTHER>
+    void assign(const moshpit_sim<OTHER>& other)
+    {
+        m_count = other.m_count;
+        lx = other.lx;
+        ly = other.ly;
+        m_size[0] = other.m_size[0];
+        m_size[1] = other.m_size[1];
+        count = other.count;
+        cellStart = other.cellStart;
+        binned = other.binned;
+        home = other.home;
+        type = other.type;
+
+        r.assign(other.r.begin(), other.r.end());
+        mpX.assign(other.mpX.begin(), other.mpX.end());
+        mpY.assign(other.mpY.begin(), other.mpY.end());
+        vx.assign(other.vx.begin(), other.vx.end());
+        vy.assign(other.vy.begin(), other.vy.end());
+        fx.assign(other.fx.begin(), other.fx.end());
+        fy.assign(other.fy.begin(), other.fy.end());
+        col.assign(other.col.begin(), other.col.end());
+    }
+
+    /// Free the crowd's storage, e.g. after it has moved to the other precision.
+    void release()
+    {
+        *this = moshpit_sim{};
+    }
+
+    /// Advance by substeps particle frames, then bin the crowd into the neighbour grid, which
+    /// the next step and any queries in between use.
+    void step(const moshpit_params& params, const int substeps, moshpit_counters& counters)
+    {
+        for (int i{}; i < substeps; ++i)
+        {
+            update(params, counters);
+        }
+        nbl_bin(counters);
+    }
+
+    /// Copy the crowd and its neighbour grid out for the views.
+    void snapshot(moshpit_snapshot& out) const
+    {
+        const int cellCount{ m_size[0] * m_size[1] };
+
+        out.side = lx;
+        out.columns = m_size[0];
+        out.rows = m_size[1];
+        out.periodic[0] = pbc[0];
+        out.periodic[1] = pbc[1];
+        out.x.assign(mpX.begin(), mpX.end());
+        out.y.assign(mpY.begin(), mpY.end());
+        out.radius.assign(r.begin(), r.end());
+        out.force.assign(col.begin(), col.end());
+        out.type.assign(type.begin(), type.end());
+
+        out.cellStart.assign(cellStart.begin(), cellStart.end());
+        out.order.assign(binned.begin(), binned.end());
+        out.occupancy = cellCount > 0 ? *std::max_element(count.begin(), count.end()) : 0;
+    }
+
+    size_t size() const { return m_count; }
+    int side() const { return lx; }
+
+    REAL x(const size_t mosher) const { return mpX[mosher]; }
+    REAL y(const size_t mosher) const { return mpY[mosher]; }
+    REAL radius(const size_t mosher) const { return r[mosher]; }
+    REAL force(const size_t mosher) const { return col[mosher]; }
+    int kind(const size_t mosher) const { return type[mosher]; }
+
+private:
+    template <typename> friend class moshpit_sim;
+
+    size_t m_count{};
+
+    std::vector<REAL> r{};
+    std::vector<REAL> mpX{};
+    std::vector<REAL> mpY{};
+    std::vector<int> type{};
+    std::vector<REAL> vx{};
+    std::vector<REAL> vy{};
+    std::vector<REAL> fx{};
+    std::vector<REAL> fy{};
+    std::vector<REAL> col{};
+
+    //neighbor list
+    int lx{};
+    int ly{};
+    int m_size[2]{ 0, 0 };
+    // the moshers in cell c are binned[cellStart[c]] up to, but not including,
+    // binned[cellStart[c + 1]]; home is the cell of each mosher
+    std::vector<int> count{};
+    std::vector<int> cellStart{};
+    std::vector<int> binned{};
+    std::vector<int> home{};
+
+    //things we can change
+    int pbc[2]{ 1, 1 };
+    int epsilon{ 100 };
+
+    //////////////////////////////////////////////////////////////    functions
+
+    int moshpit_mod_rvec(const int a, const int b, const int p, int* image)
+    {
+        *image = 1;
+
+        if (b == 0 && a == 0)
+        {
+            *image = 0;
+            return 0;
+        }
+
+        if (p != 0)
+        {
+            if (a > b) return a - b - 1;
+            if (a < 0) return a + b + 1;
+        }
+        else
+        {
+            if (a > b) return b;
+            if (a < 0) return 0;
+        }
+
+        *image = 0;
+        return a;
+    }
+
+    void nbl_bin(moshpit_counters& counters)
+    {
+        mzed::profile_scope timing{ counters.binTime };
+        std::fill(count.begin(), count.end(), 0);
+
+        for (size_t mosher{}; mosher < m_count; ++mosher)
+        {
+            const size_t indX{ std::min(static_cast<size_t>(mpX[mosher] / lx * m_size[0]), static_cast<size_t>(m_size[0] - 1)) };
+            const size_t indY{ std::min(static_cast<size_t>(mpY[mosher] / ly * m_size[1]), static_cast<size_t>(m_size[1] - 1)) };
+            home[mosher] = static_cast<int>(indX + indY * m_size[0]);
+            ++count[home[mosher]];
+        }
+
+        // store only the occupied entries, however crowded a cell gets
+        const size_t cellCount{ count.size() };
+        for (size_t cell{}; cell < cellCount; ++cell)
+        {
+            cellStart[cell + 1] = cellStart[cell] + count[cell];
+            count[cell] = 0;
+        }
+
+        for (size_t mosher{}; mosher < m_count; ++mosher)
+        {
+            const int tt{ home[mosher] };
+            binned[cellStart[tt] + count[tt]++] = static_cast<int>(mosher);
+        }
+    }
+
+    static double normRand()
+    {
+        return (double)rand() / (double)RAND_MAX;
+    }
+
+    static REAL mymod(const REAL a, const REAL b)
+    { // wrap into [0, b); floor() already handles negative a, and rounding can land exactly on b
+        const REAL m{ a - b * std::floor(a / b) };
+        return (m < b) ? m : REAL(0);
+    }
+
+    void update(const moshpit_params& params, moshpit_counters& counters)
+    {
+        mzed::allocation_scope scope{ counters.updateAllocations };
+        mzed::profile_scope timing{ counters.updateTime };
+        [[maybe_unused]] uint64_t pairs{};
+        int image[2]{ 0, 0 };
+
+        constexpr REAL tiny{ static_cast<REAL>(1e-6) };
+        constexpr REAL vhappy{ static_cast<REAL>(VHAPPY) };
+        constexpr REAL damp{ static_cast<REAL>(DAMP) };
+        constexpr REAL gdt{ static_cast<REAL>(GDT) };
+        const REAL flock{ static_cast<REAL>(params.flock) };
+
+        for (size_t mosher{}; mosher < m_count; ++mosher)
+        {
+            col[mosher] = 0;
+            fx[mosher] = 0;
+            fy[mosher] = 0;
+
+            REAL wx{};
+            REAL wy{};
+            long neigh{};
+
+            const int indX{ static_cast<int>(mpX[mosher] / lx * m_size[0]) };
+            const int indY{ static_cast<int>(mpY[mosher] / ly * m_size[1]) };
+
+            for (int ttx{ -1 }; ttx <= 1; ++ttx)
+            {
+                for (int tty{ -1 }; tty <= 1; ++tty)
+                {
+                    bool goodcell{ true };
+                    const int tixx{ moshpit_mod_rvec(indX + ttx, m_size[0] - 1, pbc[0], &image[0]) };
+                    const int tixy{ moshpit_mod_rvec(indY + tty, m_size[1] - 1, pbc[1], &image[1]) };
+
+                    if ((pbc[0] < image[0]) || (pbc[1] < image[1])) goodcell = 0;
+
+                    if (goodcell)
+                    {
+                        long cell{ tixx + (tixy * m_size[0]) };
+                        if constexpr (mzed::profiling) pairs += count[cell];
+
+                        for (int cc{ cellStart[cell] }; cc < cellStart[cell + 1]; ++cc)
+                        {
+                            long j{ binned[cc] };
+                            REAL dx{ mpX[j] - mpX[mosher] };
+                            if (image[0]) dx += lx * ttx;
+
+                            REAL dy{ mpY[j] - mpY[mosher] };
+                            if (image[1]) dy += ly * tty;
+
+                            REAL l{ std::sqrt(dx * dx + dy * dy) };
+                            if (l > tiny && l < TWO_R)
+                            {
+                                REAL r0{ r[mosher] + r[j] };
+                                REAL f{ (1 - l / r0) };
+                                REAL c0{ -(epsilon)*f * f * (l < r0) };
+
+                                fx[mosher] += c0 * dx;
+                                fy[mosher] += c0 * dy;
+                                col[mosher] += c0 * c0 * dx * dx + c0 * c0 * dy * dy; //fx[i]*fx[i] + fy[i]*fy[i]
+                            }
+
+                            if (type[mosher] > 0 && type[j] > 0 && l > tiny && l < FR)
+                            {
+                                wx += vx[j];
+                                wy += vy[j];
+                                ++neigh;
+                            }
+                        }
+                    }
+                }
+            }
+
+            const REAL wlen{ (wx * wx + wy * wy) };
+
+            if (type[mosher] > 0 && neigh > 0 && wlen > tiny)
+            {
+                fx[mosher] += flock * wx / wlen;
+                fy[mosher] += flock * wy / wlen;
+            }
+
+            const REAL vlen{ vx[mosher] * vx[mosher] + vy[mosher] * vy[mosher] };
+            const REAL vhap{ type[mosher] > 0 ? vhappy : REAL(0) };
+
+            if (vlen > tiny)
+            {
+                fx[mosher] += damp * (vhap - vlen) * vx[mosher] / vlen;
+                fy[mosher] += damp * (vhap - vlen) * vy[mosher] / vlen;
+            }
+
+            if (type[mosher] > 0)
+            {
+                fx[mosher] += static_cast<REAL>(params.noise * (normRand() - 0.5));
+                fy[mosher] += static_cast<REAL>(params.noise * (normRand() - 0.5));
+            }
+
+            for (size_t f{}; f < params.fieldCount; ++f)
+            {
+                const moshpit_field& field{ params.fields[f] };
+                const REAL dx{ static_cast<REAL>(moshpit_separation(field.x - mpX[mosher], lx, pbc[0])) };
+                const REAL dy{ static_cast<REAL>(moshpit_separation(field.y - mpY[mosher], ly, pbc[1])) };
+                const REAL d{ std::sqrt(dx * dx + dy * dy) };
+
+                if (d > tiny && d < field.radius)
+                {
+                    const REAL pull{ static_cast<REAL>(field.strength * (1 - d / field.radius)) / d };
+                    fx[mosher] += pull * dx;
+                    fy[mosher] += pull * dy;
+                }
+            }
+        }
+
+        for (size_t mosher{}; mosher < m_count; ++mosher)
+        {
+            vx[mosher] += fx[mosher] * gdt;
+            vy[mosher] += fy[mosher] * gdt;
+            mpX[mosher] += vx[mosher] * gdt;
+            mpY[mosher] += vy[mosher] * gdt;
+
+            if (pbc[0] == 0)
+            {
+                if (mpX[mosher] >= lx)
+                {
+                    mpX[mosher] = 2 * lx - mpX[mosher];
+                    vx[mosher] *= -1;
+                }
+                if (mpX[mosher] < 0)
+                {
+                    mpX[mosher] = -(mpX[mosher]);
+                    vx[mosher] *= -1;
+                }
+            }
+            else
+            {
+                if (mpX[mosher] >= lx || mpX[mosher] < 0) mpX[mosher] = mymod(mpX[mosher], lx);
+            }
+
+            if (pbc[1] == 0)
+            {
+                if (mpY[mosher] >= ly)
+                {
+                    mpY[mosher] = 2 * ly - mpY[mosher];
+                    vy[mosher] *= -1;
+                }
+                if (mpY[mosher] < 0)
+                {
+                    mpY[mosher] = -(mpY[mosher]);
+                    vy[mosher] *= -1;
+                }
+            }
+            else
+            {
+                if (mpY[mosher] >= ly || mpY[mosher] < 0) mpY[mosher] = mymod(mpY[mosher], ly);
+            }
+            /*
+             TODO: Do I need this?
+             if (dovorticity == true)
+             {
+              graph_vel(sqrt(x->vx[i]*x->vx[i] + x->vy[i]* x->vy[i]));
+             }*/
+        }
+
+        ++counters.steps;
+        if constexpr (mzed::profiling) counters.pairs += pairs;
+    }
+};
+
+/// A crowd that runs in either precision, carrying its moshers across when the precision
+/// changes, together with the running totals of the simulation behind it.
+class moshpit_crowd
+{
+public:
+    void init(const size_t moshers, const double fractionRed, const mzed::precisions precision)
+    {
+        m_sim64.release();
+        m_sim32.release();
+        m_active = precision;
+        with_sim([&](auto& sim) { sim.init(moshers, fractionRed); });
+    }
+
+    void step(const moshpit_params& params, const int substeps, const mzed::precisions precision)
+    {
+        use(precision);
+        with_sim([&](auto& sim) { sim.step(params, substeps, m_counters); });
+    }
+
+    void snapshot(moshpit_snapshot& out) const
+    {
+        if (m_active == mzed::precisions::single_precision) m_sim32.snapshot(out);
+        else m_sim64.snapshot(out);
+        out.counters = m_counters;
+    }
+
+private:
+    // one crowd per precision; only the active one holds moshers
+    moshpit_sim<double> m_sim64{};
+    moshpit_sim<float> m_sim32{};
+    mzed::precisions m_active{ mzed::precisions::double_precision };
+    moshpit_counters m_counters{};
+
+    void use(const mzed::precisions precision)
+    {
+        if (precision == m_active) return;
+
+        if (precision == mzed::precisions::single_precision)
+        {
+            m_sim32.assign(m_sim64);
+            m_sim64.release();
+        }
+        else
+        {
+            m_sim64.assign(m_sim32);
+            m_sim32.release();
+        }
+        m_active = precision;
+    }
+
+    template <typename F>
+    void with_sim(F&& f)
+    {
+        if (m_active == mzed::precisions::single_precision) f(m_sim32);
+        else f(m_sim64);
+    }
+};
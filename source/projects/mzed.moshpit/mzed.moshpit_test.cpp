@@ -5,6 +5,7 @@
 
 #include "c74_min_unittest.h"     // required unit test header
 #include "mzed.moshpit.cpp"    // need the source of our object so that we can access it
+#include "mzed.benchmark.h"
 
 // Unit tests are written using the Catch framework as described at
 // https://github.com/philsquared/Catch/blob/master/docs/tutorial.md
@@ -34,3 +35,608 @@ SCENARIO("object produces correct output") {
         */
     }
 }
+
+SCENARIO("moshers stay inside the pit") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        REQUIRE(my_object.numMoshers == 300);
+
+        WHEN("it is stepped for 100 frames") {
+            for (int frame {}; frame < 100; ++frame) my_object.step();
+
+            THEN("every mosher has a finite position inside the walls") {
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) {
+                    const auto p { my_object.position(mosher) };
+                    REQUIRE(std::isfinite(p[0]));
+                    REQUIRE(std::isfinite(p[1]));
+                    REQUIRE(p[0] >= 0.0);
+                    REQUIRE(p[0] < my_object.side());
+                    REQUIRE(p[1] >= 0.0);
+                    REQUIRE(p[1] < my_object.side());
+                }
+            }
+        }
+
+        WHEN("it is switched to single precision mid-run and stepped for 100 more frames") {
+            for (int frame {}; frame < 100; ++frame) my_object.step();
+            my_object.precision = mzed::precisions::single_precision;
+            for (int frame {}; frame < 100; ++frame) my_object.step();
+
+            THEN("the crowd carries over and stays inside the walls") {
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) {
+                    const auto p { my_object.position(mosher) };
+                    REQUIRE(std::isfinite(p[0]));
+                    REQUIRE(std::isfinite(p[1]));
+                    REQUIRE(p[0] >= 0.0);
+                    REQUIRE(p[0] < my_object.side());
+                    REQUIRE(p[1] >= 0.0);
+                    REQUIRE(p[1] < my_object.side());
+                }
+            }
+        }
+    }
+}
+
+// A seeded crowd follows the same trajectory every run. The pinned positions were dealt by
+// glibc's rand(); other C libraries deal a different sequence from the same seed, so there only
+// the repeatability is checked.
+SCENARIO("a seeded crowd matches golden data") {
+    GIVEN("A crowd of 100 scattered after srand(1)") {
+        const moshpit_params params {};
+        const auto run { [&] {
+            std::srand(1);
+            moshpit_crowd crowd {};
+            crowd.init(100, 0.15, mzed::precisions::double_precision);
+            for (int frame {}; frame < 10; ++frame) crowd.step(params, 2, mzed::precisions::double_precision);
+            moshpit_snapshot snapshot {};
+            crowd.snapshot(snapshot);
+            return snapshot;
+        } };
+
+        WHEN("it is stepped for 10 frames") {
+            const moshpit_snapshot first { run() };
+            const moshpit_snapshot again { run() };
+            std::srand(1);
+            const bool glibc { std::rand() == 1804289383 };
+
+            THEN("it lands in the same place every time") {
+                REQUIRE(first.x == again.x);
+                REQUIRE(first.y == again.y);
+            }
+
+            THEN("a few moshers are where they were when the data was taken") {
+                constexpr std::array<std::array<double, 3>, 3> golden { {
+                    { 0, 0.77836974190171393, 7.050593204327642 },
+                    { 37, 4.0031924661021216, 11.363908132449307 },
+                    { 99, 17.879841944698907, 14.173379673545226 }
+                } };
+                if (!glibc) WARN("rand() isn't glibc's; skipping the pinned positions");
+                for (const auto& [mosher, x, y] : golden) {
+                    if (!glibc) break;
+                    REQUIRE(first.x[static_cast<size_t>(mosher)] == Approx(x).margin(1e-9));
+                    REQUIRE(first.y[static_cast<size_t>(mosher)] == Approx(y).margin(1e-9));
+                }
+            }
+        }
+    }
+}
+
+// Queries are answered from the neighbour grid in the pixel coordinates out2 uses (the default
+// 200x200 view here) and must agree with checking every mosher, measuring across the wrapping
+// walls.
+SCENARIO("spatial queries agree with a search of every mosher") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit that has run for 20 frames") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        for (int frame {}; frame < 20; ++frame) my_object.step();
+
+        const double pixels { 200.0 / my_object.side() };
+        const auto distance { [&](const int mosher, const double x, const double y) {
+            const double side { my_object.side() };
+            double dx { std::fabs(my_object.position(mosher)[0] - x / pixels) };
+            double dy { std::fabs(my_object.position(mosher)[1] - y / pixels) };
+            dx = std::min(dx, side - dx);
+            dy = std::min(dy, side - dy);
+            return std::sqrt(dx * dx + dy * dy) * pixels;
+        } };
+        auto& replies = *c74::max::object_getoutput(my_object, 3);
+
+        WHEN("the 5 moshers nearest a point near a corner are asked for") {
+            my_object.nearest({ 3.0, 196.0, 5 });
+
+            THEN("they are the 5 closest, in order") {
+                std::vector<double> all {};
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) all.push_back(distance(mosher, 3.0, 196.0));
+                std::sort(all.begin(), all.end());
+
+                REQUIRE(replies.back()[1] == symbol("nearest"));
+                REQUIRE(replies.back().size() == 7);
+                for (int i {}; i < 5; ++i) REQUIRE(distance(replies.back()[i + 2], 3.0, 196.0) == Approx(all[i]));
+            }
+        }
+
+        WHEN("the moshers within 30 pixels of the centre are asked for") {
+            my_object.within({ 100.0, 100.0, 30.0 });
+
+            THEN("exactly those are sent") {
+                size_t expected {};
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) expected += distance(mosher, 100.0, 100.0) <= 30.0;
+
+                REQUIRE(replies.back()[1] == symbol("within"));
+                REQUIRE(replies.back().size() == expected + 2);
+                for (size_t i { 2 }; i < replies.back().size(); ++i) REQUIRE(distance(replies.back()[i], 100.0, 100.0) <= 30.0);
+            }
+        }
+
+        WHEN("the moshers in a rectangle are counted") {
+            my_object.count_in_rect({ 20.0, 50.0, 120.0, 90.0 });
+
+            THEN("the count matches") {
+                int expected {};
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) {
+                    const double x { my_object.position(mosher)[0] * pixels };
+                    const double y { my_object.position(mosher)[1] * pixels };
+                    expected += x >= 20.0 && x <= 120.0 && y >= 50.0 && y <= 90.0;
+                }
+
+                REQUIRE(replies.back()[1] == symbol("count_in_rect"));
+                REQUIRE(replies.back()[2] == expected);
+            }
+        }
+    }
+
+    GIVEN("An instance of moshpit") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+        auto&                      replies = *c74::max::object_getoutput(my_object, 3);
+
+        WHEN("queries are given numbers that are out of range or not numbers at all") {
+            my_object.within({ NAN, 100.0, 30.0 });
+            const size_t within_nan { replies.back().size() };
+            my_object.within({ 100.0, 100.0, INFINITY });
+            const size_t within_infinite { replies.back().size() };
+            my_object.within({ 1e300, -1e300, 30.0 });
+            my_object.count_in_rect({ -INFINITY, 0.0, 200.0, 200.0 });
+            const int rect_infinite { replies.back()[2] };
+            my_object.count_in_rect({ -1e300, -1e300, 1e300, 1e300 });
+            const int rect_huge { replies.back()[2] };
+            my_object.nearest({ 100.0, 100.0, 1e30 });
+            const size_t nearest_huge { replies.back().size() };
+            my_object.nearest({ 100.0, 100.0, -5 });
+
+            THEN("they find nothing, or are held to the pit and the crowd") {
+                REQUIRE(within_nan == 2);
+                REQUIRE(within_infinite == 2);
+                REQUIRE(rect_infinite == 0);
+                REQUIRE(rect_huge == my_object.numMoshers);
+                REQUIRE(nearest_huge == my_object.numMoshers + 2);
+                REQUIRE(replies.back().size() == 2);
+            }
+        }
+    }
+
+    GIVEN("A snapshot with a mosher whose position isn't a number") {
+        moshpit_snapshot broken {};
+        broken.side = 10;
+        broken.x = { 1.0, NAN };
+        broken.y = { 1.0, 1.0 };
+        broken.order = { 0, 1 };
+        broken.cellStart = { 0, 2 };
+
+        WHEN("the 2 moshers nearest the centre are asked for") {
+            std::vector<std::pair<double, int>> found {};
+            broken.nearest(5.0, 5.0, 2, found);
+
+            THEN("the search gives up at the edge of the pit with the one it found") {
+                REQUIRE(found.size() == 1);
+                REQUIRE(found[0].second == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("an attracting field gathers the crowd") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit with a strong field at the centre") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        const auto inside { [&] {
+            my_object.count_in_rect({ 50.0, 50.0, 150.0, 150.0 });
+            return int(c74::max::object_getoutput(my_object, 3)->back()[2]);
+        } };
+        const int before { inside() };
+        my_object.field({ 100.0, 100.0, 20.0, 150.0 });
+
+        WHEN("it runs for 50 frames") {
+            for (int frame {}; frame < 50; ++frame) my_object.step();
+
+            THEN("more moshers are in the middle of the pit") {
+                REQUIRE(inside() > before);
+            }
+
+            AND_WHEN("the field is cleared") {
+                my_object.clearfields();
+                THEN("stepping carries on") {
+                    my_object.step();
+                    REQUIRE(std::isfinite(my_object.position(0)[0]));
+                }
+            }
+        }
+    }
+
+    GIVEN("An instance of moshpit asked for fields it can't have") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        my_object.field({ 100.0, 100.0, 1e12, 150.0 });
+        my_object.field({ 100.0, 100.0, 20.0, 0.0 });
+        my_object.field({ 100.0, NAN, 20.0, 50.0 });
+
+        WHEN("it runs for a frame") {
+            std::vector<std::array<double, 2>> before {};
+            for (int mosher {}; mosher < my_object.numMoshers; ++mosher) before.push_back(my_object.position(mosher));
+            my_object.step();
+
+            THEN("the strength was limited and the others were refused, so no mosher leapt across the pit") {
+                double furthest {};
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) {
+                    const auto p { my_object.position(mosher) };
+                    REQUIRE(std::isfinite(p[0]));
+                    REQUIRE(std::isfinite(p[1]));
+                    for (int axis {}; axis < 2; ++axis) {
+                        const double moved { std::fabs(p[axis] - before[mosher][axis]) };
+                        furthest = std::max(furthest, std::min(moved, my_object.side() - moved));
+                    }
+                }
+                REQUIRE(furthest < 0.2 * my_object.side());
+            }
+        }
+    }
+}
+
+// Channel buffers for calling the object's audio operator, which sees them as an audio_bundle.
+struct test_signals {
+    std::vector<std::vector<double>> buffers;
+    std::vector<double*>             pointers;
+
+    test_signals(const int channels, const int frames)
+    : buffers(channels, std::vector<double>(frames)) {
+        for (auto& buffer : buffers) pointers.push_back(buffer.data());
+    }
+
+    audio_bundle bundle() {
+        return { pointers.data(), static_cast<long>(buffers.size()), static_cast<long>(buffers[0].size()) };
+    }
+};
+
+// Each voice of the multichannel outlet glides from where it was to the latest frame over one
+// frame period (1/fps seconds), then holds there until the next frame arrives.
+SCENARIO("the multichannel outlet follows the selected moshers") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit following moshers 5 and 7") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        my_object.select({ 5, 7 });
+        my_object.step();
+
+        WHEN("more than one frame period of audio is rendered") {
+            const int frames { static_cast<int>(my_object.samplerate() / my_object.framerate) + 64 };
+            test_signals first { 3 * my_object.voices, frames };
+            audio_bundle output { first.bundle() };
+            my_object(output, output);
+
+            THEN("the channels have reached x, y and force of each mosher") {
+                const auto p5 { my_object.position(5) };
+                const auto p7 { my_object.position(7) };
+                REQUIRE(output.samples(0)[frames - 1] == Approx(p5[0] / my_object.side()));
+                REQUIRE(output.samples(1)[frames - 1] == Approx(p5[1] / my_object.side()));
+                REQUIRE(output.samples(3)[frames - 1] == Approx(p7[0] / my_object.side()));
+                REQUIRE(output.samples(4)[frames - 1] == Approx(p7[1] / my_object.side()));
+                REQUIRE(output.samples(6)[frames - 1] == Approx(my_object.position(2)[0] / my_object.side()));
+                for (int channel {}; channel < output.channel_count(); ++channel) {
+                    REQUIRE(output.samples(channel)[frames - 1] >= 0.0);
+                    REQUIRE(output.samples(channel)[frames - 1] <= 1.0);
+                }
+            }
+
+            AND_WHEN("the pit moves on a frame and more audio is rendered") {
+                test_signals second { 3 * my_object.voices, frames };
+                audio_bundle more { second.bundle() };
+                my_object.step();
+                my_object(more, more);
+
+                THEN("the channels glide there, only cutting when a mosher wraps around the pit") {
+                    const auto smooth { [](const double from, const double to) {
+                        const double jump { std::fabs(to - from) };
+                        return jump < 0.01 || jump > 0.5;
+                    } };
+
+                    for (int channel {}; channel < more.channel_count(); ++channel) {
+                        REQUIRE(smooth(output.samples(channel)[frames - 1], more.samples(channel)[0]));
+                        for (int i { 1 }; i < frames; ++i) {
+                            REQUIRE(smooth(more.samples(channel)[i - 1], more.samples(channel)[i]));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// The outlet is fed by the clock, not by drawing, so it keeps up with the pit while the
+// window is hidden and paint never runs.
+SCENARIO("the multichannel outlet moves without a paint") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit that is on") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        my_object.on = true;
+        my_object.clock.tick();
+
+        const int    frames { static_cast<int>(my_object.samplerate() / my_object.framerate) + 64 };
+        test_signals first { 3 * my_object.voices, frames };
+        audio_bundle output { first.bundle() };
+        my_object(output, output);
+        const auto start { my_object.position(0) };
+
+        WHEN("the clock fires 10 times and more audio is rendered") {
+            for (int frame {}; frame < 10; ++frame) my_object.clock.tick();
+
+            test_signals second { 3 * my_object.voices, frames };
+            audio_bundle more { second.bundle() };
+            my_object(more, more);
+
+            THEN("the first voice has followed its mosher") {
+                const auto now { my_object.position(0) };
+                REQUIRE((now[0] != start[0] || now[1] != start[1]));
+                REQUIRE(more.samples(0)[frames - 1] == Approx(now[0] / my_object.side()));
+                REQUIRE(more.samples(1)[frames - 1] == Approx(now[1] / my_object.side()));
+            }
+        }
+    }
+}
+
+// Each frame goes out once, when it's stepped: a window repainting more often than the clock
+// fires doesn't send or record it again.
+SCENARIO("a frame is sent once however often it's painted") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit that has stepped one frame") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        auto& out1 = *c74::max::object_getoutput(my_object, 0);
+        auto& out2 = *c74::max::object_getoutput(my_object, 1);
+        my_object.bang();
+        const size_t sent { out2.size() };
+
+        WHEN("it is painted twice") {
+            my_object.paint();
+            my_object.paint();
+
+            THEN("nothing more is sent") {
+                REQUIRE(sent == static_cast<size_t>(my_object.numMoshers));
+                REQUIRE(out1.size() == sent);
+                REQUIRE(out2.size() == sent);
+            }
+        }
+
+        WHEN("it steps again") {
+            my_object.bang();
+
+            THEN("the next frame is sent") {
+                REQUIRE(out2.size() == 2 * sent);
+            }
+        }
+    }
+}
+
+// Neither stepping the simulation nor drawing it may touch the heap. Only meaningful in a build
+// configured with -DMZED_COUNT_ALLOCATIONS=ON; otherwise nothing is counted.
+SCENARIO("update and draw_all do not allocate") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        WHEN("it steps and paints 20 frames") {
+            for (int frame {}; frame < 20; ++frame) {
+                my_object.bang();
+                my_object.paint();
+            }
+
+            THEN("neither allocated") {
+                REQUIRE(my_object.update_allocations().peak == 0);
+                REQUIRE(my_object.draw_allocations().peak == 0);
+                if (mzed::counting_allocations) REQUIRE(my_object.draw_allocations().calls == 20);
+            }
+        }
+    }
+}
+
+// Discs of radius 1 can't tile the pit without some overlap, but a new crowd should start evenly
+// spread, with no pair much closer than their diameter of 2.
+SCENARIO("a new crowd starts spread out") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of moshpit") {
+        test_wrapper<mzed_moshpit> an_instance;
+        mzed_moshpit&              my_object = an_instance;
+
+        WHEN("a crowd of 2000 is scattered") {
+            my_object.numMoshers = 2000;
+            my_object.reset();
+
+            THEN("every mosher is inside the walls and none sits on top of another") {
+                const double side { my_object.side() };
+                double closest { side };
+
+                for (int a {}; a < my_object.numMoshers; ++a) {
+                    const auto p { my_object.position(a) };
+                    REQUIRE(p[0] >= 0.0);
+                    REQUIRE(p[0] < side);
+                    REQUIRE(p[1] >= 0.0);
+                    REQUIRE(p[1] < side);
+
+                    for (int b { a + 1 }; b < my_object.numMoshers; ++b) {
+                        const auto q { my_object.position(b) };
+                        double dx { std::fabs(p[0] - q[0]) };
+                        double dy { std::fabs(p[1] - q[1]) };
+                        dx = std::min(dx, side - dx);
+                        dy = std::min(dy, side - dy);
+                        closest = std::min(closest, std::sqrt(dx * dx + dy * dy));
+                    }
+                }
+                REQUIRE(closest > 1.5);
+            }
+        }
+
+        WHEN("numMoshers is changed and the pit steps") {
+            my_object.numMoshers = 500;
+            my_object.step();
+
+            THEN("a new crowd of that size is scattered") {
+                REQUIRE(my_object.side() == static_cast<int>(1.03 * std::sqrt(M_PI * 500)));
+                REQUIRE(std::isfinite(my_object.position(499)[0]));
+            }
+        }
+
+        WHEN("a crowd of 10000 runs for 10 frames") {
+            my_object.numMoshers = 10000;
+            my_object.reset();
+            for (int frame {}; frame < 10; ++frame) my_object.step();
+
+            THEN("every mosher is still in the pit and in the neighbour grid") {
+                for (int mosher {}; mosher < my_object.numMoshers; ++mosher) {
+                    const auto p { my_object.position(mosher) };
+                    REQUIRE(p[0] >= 0.0);
+                    REQUIRE(p[0] < my_object.side());
+                    REQUIRE(p[1] >= 0.0);
+                    REQUIRE(p[1] < my_object.side());
+                }
+
+                my_object.count_in_rect({ 0.0, 0.0, 200.0, 200.0 });
+                REQUIRE(int(c74::max::object_getoutput(my_object, 3)->back()[2]) == 10000);
+            }
+        }
+    }
+}
+
+// Views with the same name draw one crowd, stepped on the pit's own thread while any view is on.
+SCENARIO("views with the same name share one pit") {
+    ext_main(nullptr);
+
+    GIVEN("Two instances of moshpit named \"shared\"") {
+        test_wrapper<mzed_moshpit> first_instance;
+        test_wrapper<mzed_moshpit> second_instance;
+        mzed_moshpit&              first = first_instance;
+        mzed_moshpit&              second = second_instance;
+
+        first.name = symbol("shared");
+        second.name = symbol("shared");
+        const auto start { first.position(0) };
+
+        WHEN("one of them is turned on for a while, then off again") {
+            first.on = true;
+            for (int wait {}; wait < 200 && first.position(0) == start; ++wait) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                first.step();
+            }
+            first.on = false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            first.step();
+            second.step();
+
+            THEN("the crowd has moved, and both see it in the same place") {
+                REQUIRE(first.position(0) != start);
+                for (int mosher {}; mosher < first.numMoshers; ++mosher) {
+                    REQUIRE(first.position(mosher) == second.position(mosher));
+                }
+            }
+        }
+
+        WHEN("the other changes numMoshers") {
+            const int side { static_cast<int>(1.03 * std::sqrt(M_PI * 500)) };
+            second.numMoshers = 500;
+            second.step();
+            for (int wait {}; wait < 200 && first.side() != side; ++wait) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                first.step();
+            }
+            second.step();
+
+            THEN("the owner thread scatters a new crowd for both") {
+                REQUIRE(first.side() == side);
+                REQUIRE(second.side() == side);
+            }
+        }
+
+        WHEN("the other changes numMoshers, then this one changes noise") {
+            const int side { static_cast<int>(1.03 * std::sqrt(M_PI * 500)) };
+            second.numMoshers = 500;
+            second.step();
+            for (int wait {}; wait < 200 && first.side() != side; ++wait) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                first.step();
+            }
+            first.noise = 4.0;
+            first.step();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            first.step();
+            second.step();
+
+            THEN("the crowd keeps the other's numMoshers") {
+                REQUIRE(first.side() == side);
+                REQUIRE(second.side() == side);
+            }
+        }
+
+        WHEN("one of them leaves") {
+            second.name = symbol("");
+
+            THEN("it carries on with a pit of its own") {
+                second.step();
+                REQUIRE(second.position(0) != first.position(0));
+            }
+        }
+    }
+}
+
+// Frames per second of moshpit_crowd::step alone (each frame is frameSkip = 2 particle steps)
+// by crowd size, measured in Debug and Release builds; see mzed.benchmark.h
+constexpr std::array<std::pair<int, double>, 3> baseline_frames_per_sec { {
+    { 100, mzed::baseline(6000.0, 19000.0) },
+    { 300, mzed::baseline(1900.0, 5500.0) },
+    { 1000, mzed::baseline(560.0, 1700.0) }
+} };
+
+SCENARIO("throughput does not regress") {
+    GIVEN("Crowds of different sizes") {
+        const moshpit_params params {};
+
+        THEN("each keeps up with its baseline") {
+            for (const auto& [moshers, baseline] : baseline_frames_per_sec) {
+                moshpit_crowd crowd {};
+                crowd.init(moshers, 0.15, mzed::precisions::double_precision);
+
+                const double rate { mzed::steps_per_second(200, [&] { crowd.step(params, 2, mzed::precisions::double_precision); }) };
+                WARN(moshers << " moshers: " << rate << " frames/sec");
+                REQUIRE(mzed::meets_baseline(rate, baseline));
+            }
+        }
+    }
+}
@@ -4,9 +4,49 @@
 ///	@license	Use of this source code is governed by the GPL v3 License found in the License.md file.
 
 #include "c74_min.h"
+#include "mzed.attractor.h"
 
 using namespace c74::min;
 
+/// The Roessler equations, stepped by mzed::attractor.
+struct roessler_equations
+{
+  struct coefficients
+  {
+    double a;
+    double b;
+    double c;
+    double h;
+  };
+
+  static constexpr int sweep_axis { 0 };
+
+  /// The coefficient a sweep message names, or nullptr if it can't be swept.
+  static double coefficients::*sweepable(const symbol& name)
+  {
+    if (name == symbol("a")) return &coefficients::a;
+    if (name == symbol("b")) return &coefficients::b;
+    if (name == symbol("c")) return &coefficients::c;
+    return nullptr;
+  }
+
+  /// One Euler step of the Roessler equations, with the derivatives evaluated in REAL.
+  template <typename REAL>
+  static mzed::point step(const mzed::point& p, const coefficients& k)
+  {
+    const REAL x { static_cast<REAL>(p.x) };
+    const REAL y { static_cast<REAL>(p.y) };
+    const REAL z { static_cast<REAL>(p.z) };
+    const REAL h { static_cast<REAL>(k.h) };
+
+    return {
+      p.x + h * (-y - z),
+      p.y + h * (x + static_cast<REAL>(k.a) * y),
+      p.z + h * (static_cast<REAL>(k.b) + z * (x - static_cast<REAL>(k.c)))
+    };
+  }
+};
+
 class mzed_roessler : public object<mzed_roessler> 
 {
 public:
@@ -19,11 +59,22 @@ public:
   outlet<> outlet_x { this, "(float) x coordinate" };
   outlet<> outlet_y { this, "(float) y coordinate" };
   outlet<> outlet_z { this, "(float) z coordinate" };
+  outlet<> dumpout  { this, "stats and sweep results" };
   
+  mzed::attractor<roessler_equations> attractor { outlet_x, outlet_y, outlet_z, dumpout, { 0.01, 0.01, 0.01 } };
+
   attribute<double> r_a { this, "a", 0.02 };
   attribute<double> r_b { this, "b", 0.02 };
   attribute<double> r_c { this, "c", 5.7 };
   attribute<double> r_h { this, "timestep (h)", 0.05 };
+  attribute<mzed::precisions> precision { this, "precision", mzed::precisions::double_precision, mzed::precision_range,
+    description { "Arithmetic used for each step: double, or float derivatives accumulated in double. Float is for hearing single-precision rounding in the trajectory, not for speed: converting to float and back on every step makes it slower than double." } };
+  attribute<mzed::events> event_mode { this, "events", mzed::events::off, mzed::event_range,
+    description { "What a bang outputs: the next step (off), or the point of the next upward crossing of the section, maximum or minimum along the event axis, integrating as many steps as it takes." } };
+  attribute<mzed::axes> event_axis { this, "axis", mzed::axes::x, mzed::axis_range,
+    description { "Coordinate watched for events." } };
+  attribute<double> event_section { this, "section", 0.0,
+    description { "Value of the event axis whose upward crossings are events in crossing mode." } };
   
   argument<number> a_arg { this, "a", "Initial a value.", MIN_ARGUMENT_FUNCTION { r_a = arg; } };
   argument<number> b_arg { this, "b", "Initial b value.", MIN_ARGUMENT_FUNCTION { r_b = arg; } };
@@ -31,26 +82,58 @@ public:
 
   argument<number> h_arg { this, "h", "Initial h (timestep) value.", MIN_ARGUMENT_FUNCTION { r_h = arg; } };
 
+  /// The coefficients as the attributes have them now.
+  roessler_equations::coefficients coefficients_now() const
+  {
+    return { r_a, r_b, r_c, r_h };
+  }
+
   message<> bang
   {
     this, "bang", "Calculate next point",
     MIN_FUNCTION
     {
-      // calculate the attractor
-      const double xNew { currentX + r_h * (-currentY - currentZ) };
-      const double yNew { currentY + r_h * (currentX + r_a * currentY) };
-      const double zNew { currentZ + r_h * (r_b + currentZ * (currentX - r_c)) };
-      
-      // save the calculated values
-      currentX = xNew;
-      currentY = yNew;
-      currentZ = zNew;
-      
-      // output the calculated values
-      outlet_z.send(zNew);
-      outlet_y.send(yNew);
-      outlet_x.send(xNew);
-      
+      attractor.bang(coefficients_now(), precision.get(), event_mode.get(), event_axis.get(), event_section);
+      return {};
+    }
+  };
+  
+  message<> stats
+  {
+    this, "stats", "Report steps, steps/sec and messages sent since the last report, and frames dropped by the current or last recording, out the right outlet (plus ns per step when built with MZED_PROFILE).",
+    MIN_FUNCTION
+    {
+      attractor.stats();
+      return {};
+    }
+  };
+  
+  message<> sweep
+  {
+    this, "sweep", "Integrate many copies across a range of one coefficient on all cores, then put extrema, periods and a bifurcation diagram of x maxima in a dictionary named out the right outlet: sweep <a|b|c> <from> <to> <count> [steps] [transient]. Blocks until every run is done; count is capped at 1000, steps and transient at 100000.",
+    MIN_FUNCTION
+    {
+      if (!attractor.sweep(args, coefficients_now())) cerr << "usage: sweep <a|b|c> <from> <to> <count> [steps] [transient]" << endl;
+      return {};
+    }
+  };
+  
+  message<> allocations
+  {
+    this, "allocations", "Post the heap allocations counted in bang (debug builds with MZED_COUNT_ALLOCATIONS).",
+    MIN_FUNCTION
+    {
+      attractor.allocations(cout);
+      return {};
+    }
+  };
+  
+  message<> record
+  {
+    this, "record", "Stream every point sent out to a file: record <path> [csv|binary]. No path stops recording.",
+    MIN_FUNCTION
+    {
+      if (!attractor.record(args, cout)) cerr << "could not open file for recording" << endl;
       return {};
     }
   };
@@ -64,11 +147,6 @@ public:
       return {};
     }
   };
-  
-private:
-  double currentX { 0.01 };
-  double currentY { 0.01 };
-  double currentZ { 0.01 };
 };
 
 MIN_EXTERNAL(mzed_roessler);
@@ -5,6 +5,12 @@
 
 #include "c74_min_unittest.h"     // required unit test header
 #include "mzed.roessler.cpp"    // need the source of our object so that we can access it
+#include "mzed.benchmark.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
 
 // Unit tests are written using the Catch framework as described at
 // https://github.com/philsquared/Catch/blob/master/docs/tutorial.md
@@ -34,3 +40,293 @@ SCENARIO("object produces correct output") {
         */
     }
 }
+
+// Reference points from the double-precision integration with default settings. Approx leaves
+// room for compilers that contract multiply-adds, which moves the last few bits.
+SCENARIO("trajectory matches golden data") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of roessler") {
+        test_wrapper<mzed_roessler> an_instance;
+        mzed_roessler&              my_object = an_instance;
+
+        WHEN("1000 bangs are received") {
+            for (int step {}; step < 1000; ++step) my_object.bang();
+
+            THEN("x follows the reference trajectory") {
+                auto& output = *c74::max::object_getoutput(my_object, 0);
+                REQUIRE(output.size() == 1000);
+                REQUIRE(double(output[99][1]) == Approx(0.018740488692563943));
+                REQUIRE(double(output[999][1]) == Approx(0.072607061742341));
+            }
+            THEN("y follows the reference trajectory") {
+                auto& output = *c74::max::object_getoutput(my_object, 1);
+                REQUIRE(output.size() == 1000);
+                REQUIRE(double(output[99][1]) == Approx(-0.009232894295209758));
+                REQUIRE(double(output[999][1]) == Approx(0.05325084385676696));
+            }
+            THEN("z follows the reference trajectory") {
+                auto& output = *c74::max::object_getoutput(my_object, 2);
+                REQUIRE(output.size() == 1000);
+                REQUIRE(double(output[99][1]) == Approx(0.003519398130416238));
+                REQUIRE(double(output[999][1]) == Approx(0.003558817546601098));
+            }
+        }
+    }
+}
+
+// Running in float evaluates each derivative in single precision but keeps accumulating the
+// state in double. For the first few hundred steps that stays within 1e-4 of the double path;
+// after that the attractor's own sensitivity separates any two trajectories, so longer runs
+// are only comparable statistically.
+SCENARIO("single precision tracks the double path") {
+    ext_main(nullptr);
+
+    GIVEN("A double and a float instance of roessler") {
+        test_wrapper<mzed_roessler> double_instance;
+        test_wrapper<mzed_roessler> float_instance;
+        mzed_roessler&              double_object = double_instance;
+        mzed_roessler&              float_object = float_instance;
+
+        float_object.precision = mzed::precisions::single_precision;
+
+        WHEN("both are banged 300 times") {
+            for (int step {}; step < 300; ++step) {
+                double_object.bang();
+                float_object.bang();
+            }
+
+            THEN("x, y and z agree to within 1e-4") {
+                for (int axis {}; axis < 3; ++axis) {
+                    auto& expected = *c74::max::object_getoutput(double_object, axis);
+                    auto& actual = *c74::max::object_getoutput(float_object, axis);
+                    REQUIRE(double(actual.back()[1]) == Approx(double(expected.back()[1])).epsilon(1e-4).margin(1e-4));
+                }
+            }
+        }
+    }
+}
+
+// In crossing mode each bang reports where the trajectory last passed upwards through the
+// section, linearly interpolated between the steps either side of it.
+SCENARIO("crossing events land on the section") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of roessler watching x = 0") {
+        test_wrapper<mzed_roessler> an_instance;
+        mzed_roessler&              my_object = an_instance;
+
+        my_object.event_mode = mzed::events::crossing;
+        REQUIRE(my_object.event_section == 0.0);
+
+        WHEN("it is banged 5 times") {
+            for (int event {}; event < 5; ++event) my_object.bang();
+
+            THEN("every event has x on the section and y moving through it") {
+                auto& xs = *c74::max::object_getoutput(my_object, 0);
+                auto& ys = *c74::max::object_getoutput(my_object, 1);
+                REQUIRE(xs.size() == 5);
+                for (size_t event {}; event < xs.size(); ++event) {
+                    REQUIRE(double(xs[event][1]) == Approx(0.0).margin(1e-12));
+                    REQUIRE(double(ys[event][1]) < 0.0);    // dx/dt = -y - z > 0 needs y < -z
+                }
+            }
+        }
+    }
+}
+
+// Sweeping c walks the Roessler system through its period-doubling cascade: one maximum of x
+// per orbit at c = 4, two at c = 9 and four at c = 13.
+SCENARIO("a sweep of c finds the period doublings") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of roessler") {
+        test_wrapper<mzed_roessler> an_instance;
+        mzed_roessler&              my_object = an_instance;
+
+        WHEN("c is swept from 4 to 13 in 10 runs") {
+            const auto runs { my_object.attractor.sweep(symbol("c"), { 4.0, 13.0, 10, 10000, 5000 }, my_object.coefficients_now()) };
+
+            THEN("each run settles on the expected cycle") {
+                REQUIRE(runs.size() == 10);
+                REQUIRE(runs[0].value == Approx(4.0));
+                REQUIRE(runs[9].value == Approx(13.0));
+                for (const auto& run : runs) REQUIRE_FALSE(run.diverged);
+                REQUIRE(runs[0].cycle == 1);
+                REQUIRE(runs[5].cycle == 2);
+                REQUIRE(runs[9].cycle == 4);
+                REQUIRE(runs[5].period == Approx(2 * runs[0].period).epsilon(0.05));
+            }
+        }
+
+        WHEN("an unknown coefficient is swept") {
+            THEN("nothing is run") {
+                REQUIRE(my_object.attractor.sweep(symbol("h"), { 0.01, 0.1, 10, 1000, 0 }, my_object.coefficients_now()).empty());
+            }
+        }
+
+        WHEN("a sweep asks for more than the limits") {
+            const auto settings { mzed::sweep_request({ symbol("c"), 4.0, 13.0, 1e9, 1e12, 1e12 }) };
+
+            THEN("it is cut down to them") {
+                REQUIRE(settings);
+                REQUIRE(settings->count == mzed::sweep_max_count);
+                REQUIRE(settings->steps == mzed::sweep_max_steps);
+                REQUIRE(settings->transient == mzed::sweep_max_steps);
+            }
+        }
+
+        WHEN("a sweep asks for no runs") {
+            THEN("it is refused") {
+                REQUIRE_FALSE(mzed::sweep_request({ symbol("c"), 4.0, 13.0, 0 }));
+            }
+        }
+    }
+}
+
+// The recorder writes every frame it accepts, in either format, and counts the ones it can't
+// take when the writer falls behind instead of waiting for it.
+SCENARIO("recordings hold every frame that was not dropped") {
+    // a name of its own for each run, so test runs side by side don't write over each other
+    const std::string unique { std::to_string(std::random_device {}()) + "_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) };
+    const std::string filename { (std::filesystem::temp_directory_path() / ("mzed_recorder_test_" + unique)).string() };
+
+    GIVEN("A recorder of two columns") {
+        mzed::recorder<2> rec { { "x", "y" } };
+
+        WHEN("three frames are recorded as csv") {
+            REQUIRE(rec.start(filename, mzed::recorder<2>::format::csv));
+            for (int frame {}; frame < 3; ++frame) REQUIRE(rec.push(frame, 0.1 * frame));
+            rec.stop();
+
+            THEN("the file has a header and one line per frame") {
+                std::ifstream in { filename };
+                std::string   line;
+                std::getline(in, line);
+                REQUIRE(line == "x,y");
+                for (int frame {}; frame < 3; ++frame) {
+                    double x {}, y {};
+                    char   comma {};
+                    REQUIRE(in >> x >> comma >> y);
+                    REQUIRE(x == frame);
+                    REQUIRE(y == 0.1 * frame);
+                }
+                REQUIRE(rec.recorded() == 3);
+                REQUIRE(rec.dropped() == 0);
+            }
+        }
+
+        WHEN("three frames are recorded as binary") {
+            REQUIRE(rec.start(filename, mzed::recorder<2>::format::binary));
+            for (int frame {}; frame < 3; ++frame) REQUIRE(rec.push(frame, 0.1 * frame));
+            rec.stop();
+
+            THEN("the file holds the doubles as they were") {
+                std::ifstream in { filename, std::ios::binary };
+                double        values[6] {};
+                in.read(reinterpret_cast<char*>(values), sizeof(values));
+                REQUIRE(in.gcount() == sizeof(values));
+                REQUIRE(in.peek() == std::ifstream::traits_type::eof());
+                for (int frame {}; frame < 3; ++frame) {
+                    REQUIRE(values[2 * frame] == frame);
+                    REQUIRE(values[2 * frame + 1] == 0.1 * frame);
+                }
+            }
+        }
+    }
+
+    GIVEN("A recorder with room for 16 frames") {
+        using small_recorder = mzed::recorder<2, 16>;
+        small_recorder rec { { "x", "y" } };
+
+        WHEN("frames are pushed faster than they can be written") {
+            REQUIRE(rec.start(filename, small_recorder::format::binary));
+            const size_t pushed { 100000 };
+            size_t       refused {};
+            for (size_t frame {}; frame < pushed; ++frame) {
+                if (!rec.push(frame, frame)) ++refused;
+            }
+            rec.stop();
+
+            THEN("every frame is either written or counted as dropped") {
+                REQUIRE(refused > 0);
+                REQUIRE(rec.dropped() == refused);
+                REQUIRE(rec.recorded() + rec.dropped() == pushed);
+                REQUIRE(std::filesystem::file_size(filename) == rec.recorded() * sizeof(small_recorder::frame));
+            }
+        }
+
+        WHEN("it is started again") {
+            REQUIRE(rec.start(filename, small_recorder::format::binary));
+            for (int frame {}; frame < 100; ++frame) rec.push(frame, frame);
+            rec.stop();
+            REQUIRE(rec.start(filename, small_recorder::format::binary));
+            REQUIRE(rec.push(1, 2));
+            rec.stop();
+
+            THEN("the counts and the file start from the new recording") {
+                REQUIRE(rec.recorded() == 1);
+                REQUIRE(rec.dropped() == 0);
+                REQUIRE(std::filesystem::file_size(filename) == sizeof(small_recorder::frame));
+            }
+        }
+    }
+
+    std::filesystem::remove(filename);
+}
+
+// bang must not touch the heap: not to step, search for events or record. What the outlets'
+// receivers do with the point is theirs, and isn't counted. Only meaningful in a build
+// configured with -DMZED_COUNT_ALLOCATIONS=ON; otherwise nothing is counted.
+SCENARIO("bang does not allocate") {
+    ext_main(nullptr);
+
+    GIVEN("An instance of roessler recording to a file") {
+        test_wrapper<mzed_roessler> an_instance;
+        mzed_roessler&              my_object = an_instance;
+
+        const std::string unique { std::to_string(std::random_device {}()) + "_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) };
+        const std::string filename { (std::filesystem::temp_directory_path() / ("mzed_allocations_test_" + unique + ".csv")).string() };
+        my_object.record({ symbol(filename.c_str()) });
+
+        WHEN("it is banged stepping and watching for maxima") {
+            for (int step {}; step < 1000; ++step) my_object.bang();
+            my_object.event_mode = mzed::events::maxima;
+            for (int event {}; event < 100; ++event) my_object.bang();
+
+            THEN("no bang allocated") {
+                const auto& counted { my_object.attractor.bang_allocations() };
+                REQUIRE(counted.peak == 0);
+                if (mzed::counting_allocations) REQUIRE(counted.calls == 1100);
+            }
+        }
+
+        my_object.record();
+        std::filesystem::remove(filename);
+    }
+}
+
+// Steps per second of roessler_equations::step<double> alone, measured in Debug and Release
+// builds; see mzed.benchmark.h
+constexpr double baseline_steps_per_sec { mzed::baseline(75.0e6, 135.0e6) };
+
+SCENARIO("throughput does not regress") {
+    ext_main(nullptr);
+
+    GIVEN("The roessler equations with the default coefficients") {
+        test_wrapper<mzed_roessler> an_instance;
+        mzed_roessler&              my_object = an_instance;
+        const auto k { my_object.coefficients_now() };
+        mzed::point p { my_object.attractor.current };
+
+        WHEN("they are stepped 1000000 times") {
+            const double rate { mzed::steps_per_second(1000000, [&] { p = roessler_equations::step<double>(p, k); }) };
+
+            THEN("they keep up with the baseline") {
+                WARN("roessler: " << rate << " steps/sec");
+                REQUIRE(std::isfinite(p.x));
+                REQUIRE(mzed::meets_baseline(rate, baseline_steps_per_sec));
+            }
+        }
+    }
+}